@@ -0,0 +1,97 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#include "GrassGenerationPlan.h"
+
+#include "GrassPlugin.h"
+#include "Landscape.h"
+
+int32 FGrassGenerationPlan::GetComponentsToAllocate() const
+{
+	int32 Count = 0;
+	for (const FGrassLandscapePlan& Landscape : Landscapes)
+	{
+		Count += Landscape.ComponentsToAllocate.Num();
+	}
+	return Count;
+}
+
+int32 FGrassGenerationPlan::GetWeightmapsToWrite() const
+{
+	int32 Count = 0;
+	for (const FGrassLandscapePlan& Landscape : Landscapes)
+	{
+		Count += Landscape.WeightmapsToWrite;
+	}
+	return Count;
+}
+
+int64 FGrassGenerationPlan::GetTexelsToWrite() const
+{
+	int64 Count = 0;
+	for (const FGrassLandscapePlan& Landscape : Landscapes)
+	{
+		Count += Landscape.TexelsToWrite;
+	}
+	return Count;
+}
+
+int64 FGrassGenerationPlan::GetBytesToTouch() const
+{
+	return GetTexelsToWrite() * static_cast<int64>(sizeof(FColor));
+}
+
+double FGrassGenerationPlan::GetEstimatedFillSeconds() const
+{
+	if (FillTexelsPerSecond <= 0.0)
+	{
+		return 0.0;
+	}
+
+	int64 LargestLandscapeTexels = 0;
+	for (const FGrassLandscapePlan& Landscape : Landscapes)
+	{
+		LargestLandscapeTexels = FMath::Max(LargestLandscapeTexels, Landscape.TexelsToWrite);
+	}
+
+	const double SpreadTexels = static_cast<double>(GetTexelsToWrite()) / FMath::Max(1, Concurrency);
+	return FMath::Max(static_cast<double>(LargestLandscapeTexels), SpreadTexels) / FillTexelsPerSecond;
+}
+
+void FGrassGenerationPlan::Log() const
+{
+	constexpr double BytesPerMegabyte = 1024.0 * 1024.0;
+
+	UE_LOG(LogGrassPlugin, Log, TEXT("Grass generation plan: %d landscape(s)."), Landscapes.Num());
+
+	for (const FGrassLandscapePlan& Landscape : Landscapes)
+	{
+		const ALandscape* Actor = Landscape.Fill.Landscape.Get();
+		UE_LOG(LogGrassPlugin, Log,
+			TEXT("  '%s': %s material, %s, %d of %d component(s) to allocate, up to %d weightmap(s), %.1f MB to touch."),
+			Actor ? *Actor->GetName() : TEXT("<gone>"),
+			Landscape.bAssignMaterial ? TEXT("assigns") : TEXT("keeps"),
+			Landscape.bHasGrassLayer ? TEXT("fills grass") : TEXT("no grass layer"),
+			Landscape.ComponentsToAllocate.Num(), Landscape.ComponentCount, Landscape.WeightmapsToWrite,
+			Landscape.TexelsToWrite * sizeof(FColor) / BytesPerMegabyte);
+	}
+
+	FString PackageList;
+	for (const FName LayerName : LayerInfosToCreate)
+	{
+		PackageList += PackageList.IsEmpty() ? LayerName.ToString() : TEXT(", ") + LayerName.ToString();
+	}
+
+	UE_LOG(LogGrassPlugin, Log, TEXT("  %d layer info package(s) to create and save%s%s."),
+		LayerInfosToCreate.Num(), PackageList.IsEmpty() ? TEXT("") : TEXT(": "), *PackageList);
+
+	UE_LOG(LogGrassPlugin, Log,
+		TEXT("  %d component(s) to allocate, up to %d weightmap(s) to write, %.1f MB to touch, %d volume(s) to spawn."),
+		GetComponentsToAllocate(), GetWeightmapsToWrite(), GetBytesToTouch() / BytesPerMegabyte,
+		VirtualTextureVolumesToSpawn);
+
+	UE_LOG(LogGrassPlugin, Log,
+		TEXT("  Estimated %.2f s of fill at %.1f Mtexel/s per thread on %d thread(s)%s, plus %.2f s of settle delay."),
+		GetEstimatedFillSeconds(), FillTexelsPerSecond / 1.0e6, Concurrency,
+		Rules.DependsOnTerrain() ? TEXT(" (terrain build and slope limit not included)") : TEXT(""),
+		SettleSeconds);
+}
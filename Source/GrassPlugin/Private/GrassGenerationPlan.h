@@ -0,0 +1,91 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GrassLandscapeWork.h"
+#include "GrassWeightRules.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+
+class ULandscapeComponent;
+
+/** What a generation run will do to one landscape. */
+struct FGrassLandscapePlan
+{
+	/**
+	 * The landscape, and its grass layer info once one exists. Planning fills in the layer info
+	 * when the landscape already has it; SetupLayerInfos does when it has to be created.
+	 */
+	FGrassLandscapeWork Fill;
+
+	/** Whether ApplyLandscapeMaterials will reassign the landscape's material. */
+	bool bAssignMaterial = false;
+
+	/** Whether LandscapeMaterial exposes GrassLayerName at all. Nothing is filled if not. */
+	bool bHasGrassLayer = false;
+
+	int32 ComponentCount = 0;
+
+	/**
+	 * Components with no grass allocation yet, each of which SetupLayerInfos reallocates. Where
+	 * the grass layer info does not exist yet, allocations are matched by layer name;
+	 * SetupLayerInfos checks every component again against the layer info itself.
+	 */
+	TArray<TWeakObjectPtr<ULandscapeComponent>> ComponentsToAllocate;
+
+	/**
+	 * Weightmap textures the fill writes. An upper bound: each component still to be allocated
+	 * is counted as a new texture, though reallocation often finds a free channel instead.
+	 */
+	int32 WeightmapsToWrite = 0;
+
+	/** Weightmap texels the fill writes. */
+	int64 TexelsToWrite = 0;
+};
+
+/**
+ * Everything a generation run will do, worked out without changing anything.
+ *
+ * Built by AGrassGenerator::BuildGenerationPlan, which walks the same decisions as
+ * ApplyLandscapeMaterials, SetupLayerInfos and FillGrassLayers but only reads. The "Plan Grass
+ * Generation" button logs it; GenerateGrass hands the same object to every pass, so the run
+ * does what was planned and none of the walk is repeated.
+ */
+struct FGrassGenerationPlan
+{
+	TArray<FGrassLandscapePlan> Landscapes;
+
+	/** What the fill computes each grass weight from. */
+	FGrassWeightRules Rules;
+
+	/** Layer info assets that do not exist yet. Each is a package created and saved to disk. */
+	TArray<FName> LayerInfosToCreate;
+
+	int32 VirtualTextureVolumesToSpawn = 0;
+
+	/** Single-thread throughput of the fill under Rules, measured on this machine, terrain excluded. */
+	double FillTexelsPerSecond = 0.0;
+
+	/** Threads the concurrent fill stage can use, the game thread included. */
+	int32 Concurrency = 1;
+
+	/** Time the run spends waiting on timers for the landscape system to catch up. */
+	double SettleSeconds = 0.0;
+
+	int32 GetComponentsToAllocate() const;
+	int32 GetWeightmapsToWrite() const;
+	int64 GetTexelsToWrite() const;
+
+	/** Weightmap memory the fill reads and writes. */
+	int64 GetBytesToTouch() const;
+
+	/**
+	 * Fill time from the measured throughput. Landscapes run concurrently, so the estimate is
+	 * bounded below by the largest one. Excludes material compilation and package saves, which
+	 * this plugin has no way to measure ahead of time.
+	 */
+	double GetEstimatedFillSeconds() const;
+
+	/** Writes the plan to LogGrassPlugin. */
+	void Log() const;
+};
@@ -4,12 +4,26 @@
 
 #include "Engine/World.h"
 #include "EngineUtils.h"
+#include "GrassGenerationPlan.h"
+#include "GrassKernelAdapters.h"
+#include "GrassLandscapeWork.h"
 #include "GrassPlugin.h"
+#include "GrassScratchPool.h"
+#include "GrassTerrainCache.h"
+#include "GrassWeightmapUndo.h"
+#include "GrassWeightRules.h"
+#include "GrassWeightTileCache.h"
+#include "HAL/PlatformTime.h"
+#include "Hash/xxhash.h"
+#include "Kernels/GrassTerrainKernels.h"
 #include "Materials/MaterialInterface.h"
+#include "Misc/Compression.h"
+#include "Misc/Paths.h"
 #include "PhysicalMaterials/PhysicalMaterial.h"
 #include "TimerManager.h"
 
 #if WITH_EDITOR
+#include "Async/TaskGraphInterfaces.h"
 #include "Components/RuntimeVirtualTextureComponent.h"
 #include "Engine/Texture2D.h"
 #include "Landscape.h"
@@ -17,6 +31,7 @@
 #include "LandscapeInfo.h"
 #include "LandscapeLayerInfoObject.h"
 #include "LandscapeProxy.h"
+#include "Misc/ITransaction.h"
 #include "Misc/PackageName.h"
 #include "ScopedTransaction.h"
 #include "UObject/Package.h"
@@ -52,29 +67,428 @@ namespace
 	 */
 	constexpr float DefaultLandscapeSettleDelay = 0.1f;
 
+	/** Default cap on the weight tile cache, in megabytes. */
+	constexpr int32 DefaultWeightCacheSizeLimit = 512;
+
+	/** Default weight rules: no slope limit and no noise, so a fresh actor fills the layer evenly. */
+	constexpr float DefaultMaxGrassSlope = 90.0f;
+	constexpr float DefaultGrassNoiseStrength = 0.0f;
+	constexpr int32 DefaultGrassNoiseSeed = 0;
+	constexpr float DefaultGrassNoiseScale = 64.0f;
+	constexpr int32 DefaultGrassNoiseOctaves = 4;
+
+	/** Smallest noise scale, in vertices, matching the property's ClampMin: two vertices per lattice cell. */
+	constexpr float MinGrassNoiseScale = 2.0f;
+
+	/**
+	 * Mixed into every weight tile key. Bump when the weight computation changes in a way the
+	 * rules do not capture, so tiles from older builds stop matching.
+	 */
+	constexpr uint32 WeightTileKeyVersion = 4;
+
 	/** Full weight for a landscape layer, in weightmap units. */
 	constexpr uint8 FullLayerWeight = 255;
 
-	/** Half a texel, the offset used to centre the virtual texture snap on the landscape grid. */
-	constexpr float HalfTexel = 0.5f;
-
 #if WITH_EDITOR
 	/**
-	 * Maps a weightmap channel index onto the FColor component holding it.
-	 *
-	 * Returned as a pointer-to-member so the branch is resolved once per texture rather than
-	 * once per pixel, and so the mapping does not depend on FColor's in-memory byte order.
+	 * Resolves where the grass layer lives on each of the landscape's components and locks every
+	 * weightmap involved. Components sharing a texture share one lock. Game thread only.
+	 */
+	void LockGrassTextures(FGrassLandscapeWork& Work)
+	{
+		ALandscape* Landscape = Work.Landscape.Get();
+		ULandscapeLayerInfoObject* GrassLayerInfo = Work.GrassLayerInfo.Get();
+		if (!Landscape || !GrassLayerInfo)
+		{
+			return;
+		}
+
+		TArray<ULandscapeComponent*> LandscapeComponents;
+		Landscape->GetComponents(LandscapeComponents);
+		Work.ComponentCount = LandscapeComponents.Num();
+
+		TMap<UTexture2D*, int32> WeightmapIndices;
+
+		for (ULandscapeComponent* Component : LandscapeComponents)
+		{
+			if (!Component)
+			{
+				continue;
+			}
+
+			for (const FWeightmapLayerAllocationInfo& Allocation : Component->GetWeightmapLayerAllocations(true))
+			{
+				if (Allocation.LayerInfo != GrassLayerInfo)
+				{
+					continue;
+				}
+
+				const TArray<UTexture2D*>& WeightmapTextures = Component->GetWeightmapTextures();
+				if (!WeightmapTextures.IsValidIndex(Allocation.WeightmapTextureIndex))
+				{
+					UE_LOG(LogGrassPlugin, Warning,
+						TEXT("FillGrassLayers: weightmap index %d is out of range on '%s'."),
+						Allocation.WeightmapTextureIndex, *Component->GetName());
+					continue;
+				}
+
+				// Checked before the name is read from it; the previous version logged the texture
+				// name first and only then tested for null.
+				UTexture2D* WeightmapTexture = WeightmapTextures[Allocation.WeightmapTextureIndex];
+				if (!WeightmapTexture || !WeightmapTexture->GetPlatformData())
+				{
+					UE_LOG(LogGrassPlugin, Warning,
+						TEXT("FillGrassLayers: no platform data for the weightmap on '%s'."), *Component->GetName());
+					continue;
+				}
+
+				// The layer's channel comes from the allocation. Writing all four components - as
+				// the previous version did, despite a comment stating grass was on red - set every
+				// layer sharing this texture to full weight, not just grass.
+				const int32 ChannelOffset = GrassKernels::GetChannelOffset(Allocation.WeightmapTextureChannel);
+				if (ChannelOffset == INDEX_NONE)
+				{
+					UE_LOG(LogGrassPlugin, Warning, TEXT("FillGrassLayers: unexpected weightmap channel %d on '%s'."),
+						Allocation.WeightmapTextureChannel, *Component->GetName());
+					continue;
+				}
+
+				int32 WeightmapIndex = INDEX_NONE;
+				if (const int32* LockedIndex = WeightmapIndices.Find(WeightmapTexture))
+				{
+					WeightmapIndex = *LockedIndex;
+				}
+				else
+				{
+					FTexture2DMipMap& Mip = WeightmapTexture->GetPlatformData()->Mips[0];
+					FColor* Pixels = static_cast<FColor*>(Mip.BulkData.Lock(LOCK_READ_WRITE));
+					if (!Pixels)
+					{
+						Mip.BulkData.Unlock();
+						UE_LOG(LogGrassPlugin, Warning, TEXT("FillGrassLayers: could not lock the weightmap on '%s'."),
+							*Component->GetName());
+						continue;
+					}
+
+					FGrassLockedWeightmap& Locked = Work.Weightmaps.AddDefaulted_GetRef();
+					Locked.Texture = WeightmapTexture;
+					Locked.Pixels = Pixels;
+					Locked.Size = FIntPoint(Mip.SizeX, Mip.SizeY);
+
+					WeightmapIndex = Work.Weightmaps.Num() - 1;
+					WeightmapIndices.Add(WeightmapTexture, WeightmapIndex);
+				}
+
+				// Only this component's part of the texture: neighbouring components sharing the
+				// weightmap may hold a different layer in the same channel.
+				const FIntPoint TextureSize = Work.Weightmaps[WeightmapIndex].Size;
+				const int32 ComponentTexels = (Component->SubsectionSizeQuads + 1) * Component->NumSubsections;
+				const FIntPoint Offset(
+					FMath::RoundToInt(Component->WeightmapScaleBias.Z * TextureSize.X),
+					FMath::RoundToInt(Component->WeightmapScaleBias.W * TextureSize.Y));
+
+				FGrassWeightmapRegion& Region = Work.Regions.AddDefaulted_GetRef();
+				Region.WeightmapIndex = WeightmapIndex;
+				Region.Rect = FIntRect(Offset, Offset + FIntPoint(ComponentTexels, ComponentTexels));
+				Region.Rect.Clip(FIntRect(FIntPoint::ZeroValue, TextureSize));
+				Region.ChannelOffset = ChannelOffset;
+				Region.SectionBase = Component->GetSectionBase();
+				Region.SubsectionSizeQuads = Component->SubsectionSizeQuads;
+			}
+		}
+	}
+
+	/**
+	 * Cache key for Region's weights: where it sits and how large it is, the rules, and - when a
+	 * rule reads it - TerrainHash, the input hash of the terrain under it, which already covers
+	 * its heights and its neighbours'.
+	 */
+	uint64 MakeWeightTileKey(const FGrassWeightmapRegion& Region, uint64 TerrainHash, const FGrassWeightRules& Rules)
+	{
+		FXxHash64Builder Builder;
+		Builder.Update(&WeightTileKeyVersion, sizeof(WeightTileKeyVersion));
+
+		const FIntPoint RegionSize = Region.Rect.Size();
+		Builder.Update(&RegionSize, sizeof(RegionSize));
+		Builder.Update(&Region.SectionBase, sizeof(Region.SectionBase));
+		Builder.Update(&Region.SubsectionSizeQuads, sizeof(Region.SubsectionSizeQuads));
+
+		// Left out otherwise, so editing the heights does not write new copies of the same tile.
+		if (Rules.DependsOnTerrain())
+		{
+			Builder.Update(&TerrainHash, sizeof(TerrainHash));
+		}
+
+		Rules.AppendToHash(Builder);
+		return Builder.Finalize().Hash;
+	}
+
+	/**
+	 * Writes the grass weights into every region of Work, recording what changed into
+	 * Work.UndoTiles. Weights come from WeightCache when it has them, and are computed and added
+	 * to it otherwise; only the regions computed have their terrain decoded. Touches locked
+	 * pixels, the terrain cache and the cache directory only; safe off the game thread.
+	 */
+	void FillGrassRegions(FGrassLandscapeWork& Work, const FGrassWeightRules& Rules, FGrassWeightTileCache* WeightCache)
+	{
+		FGrassScratchScope Scratch;
+
+		// A rule that reads the terrain needs it in the key: a key without it would go on serving
+		// a tile after the heights under it changed. The hash comes from the raw heightmap texels,
+		// so a region found in the cache never has its terrain decoded.
+		const auto GetTerrainHash = [&Work](const FGrassWeightmapRegion& Region)
+		{
+			return Work.Terrain ? Work.Terrain->GetInputHash(Region.SectionBase) : 0;
+		};
+		const auto IsCacheable = [&Rules, WeightCache](uint64 TerrainHash)
+		{
+			return WeightCache && (TerrainHash != 0 || !Rules.DependsOnTerrain());
+		};
+
+		if (Work.Terrain)
+		{
+			Work.Terrain->HashInputs();
+
+			TArray<FIntPoint> TerrainToBuild;
+			for (const FGrassWeightmapRegion& Region : Work.Regions)
+			{
+				const uint64 TerrainHash = GetTerrainHash(Region);
+				if (!IsCacheable(TerrainHash) || !WeightCache->Contains(MakeWeightTileKey(Region, TerrainHash, Rules)))
+				{
+					TerrainToBuild.Add(Region.SectionBase);
+				}
+			}
+
+			Work.Terrain->Build(TerrainToBuild);
+		}
+
+		// Sized from the component resolution before the first component, so an arena is grown
+		// once, not every time a larger region comes along.
+		int32 MaxRegionArea = 0;
+		for (const FGrassWeightmapRegion& Region : Work.Regions)
+		{
+			MaxRegionArea = FMath::Max(MaxRegionArea, Region.Rect.Area());
+		}
+
+		const int32 MaxTileArea = FMath::Min(MaxRegionArea, FMath::Square(GrassWeightmapDelta::TileSize));
+		Scratch->Get(EGrassScratchBuffer::Weights, MaxRegionArea);
+		Scratch->Get(EGrassScratchBuffer::Before, MaxTileArea);
+		Scratch->Get(EGrassScratchBuffer::After, MaxTileArea);
+		Scratch->Get(EGrassScratchBuffer::Compressed, FCompression::CompressMemoryBound(NAME_Zlib, MaxTileArea));
+
+		for (const FGrassWeightmapRegion& Region : Work.Regions)
+		{
+			const FGrassLockedWeightmap& Weightmap = Work.Weightmaps[Region.WeightmapIndex];
+			const FIntPoint RegionSize = Region.Rect.Size();
+			const TArrayView<uint8> Weights = Scratch->Get(EGrassScratchBuffer::Weights, Region.Rect.Area());
+
+			const uint64 TerrainHash = GetTerrainHash(Region);
+			const bool bCacheable = IsCacheable(TerrainHash);
+			const uint64 Key = bCacheable ? MakeWeightTileKey(Region, TerrainHash, Rules) : 0;
+
+			if (!bCacheable || !WeightCache->Get(Key, RegionSize, Weights))
+			{
+				const FGrassTerrainTile* Terrain = Work.Terrain ? Work.Terrain->FindTile(Region.SectionBase) : nullptr;
+
+				// Found by Contains above but unreadable, or trimmed since: decoded now instead.
+				if (!Terrain && TerrainHash != 0)
+				{
+					Work.Terrain->Build(MakeArrayView(&Region.SectionBase, 1));
+					Terrain = Work.Terrain->FindTile(Region.SectionBase);
+				}
+
+				EvaluateGrassWeights(Rules, Region, Terrain, Weights);
+				if (bCacheable)
+				{
+					WeightCache->Put(Key, RegionSize, Weights);
+				}
+			}
+
+			GrassWeightmapDelta::ForEachTile(Region.Rect, [&](const FIntRect& Tile)
+			{
+				const GrassKernels::FTexelRect TexelTile = GrassKernels::ToTexelRect(Tile);
+				const uint8* const TileWeights = Weights.GetData()
+					+ (Tile.Min.Y - Region.Rect.Min.Y) * RegionSize.X + (Tile.Min.X - Region.Rect.Min.X);
+
+				const TArrayView<uint8> Before = Scratch->Get(EGrassScratchBuffer::Before, Tile.Area());
+				GrassKernels::CaptureChannel(GrassKernels::AsTexels(Weightmap.Pixels), Weightmap.Size.X, TexelTile,
+					Region.ChannelOffset, Before.GetData());
+				GrassKernels::WriteChannel(GrassKernels::AsTexels(Weightmap.Pixels), Weightmap.Size.X, TexelTile,
+					Region.ChannelOffset, TileWeights, RegionSize.X);
+
+				FGrassWeightmapDeltaTile DeltaTile;
+				DeltaTile.WeightmapIndex = Region.WeightmapIndex;
+				if (GrassWeightmapDelta::RecordTile(
+					Weightmap.Pixels, Weightmap.Size.X, Tile, Region.ChannelOffset, Before, *Scratch, DeltaTile))
+				{
+					Work.UndoTiles.Add(MoveTemp(DeltaTile));
+				}
+			});
+		}
+	}
+
+	/**
+	 * Turns the tiles the concurrent stage recorded into an undo record on the landscape, and
+	 * returns the bytes it adds to the transaction. Must run before the weightmaps are unlocked,
+	 * while Work still lists them. Game thread only.
+	 */
+	SIZE_T StoreGrassUndo(FGrassLandscapeWork& Work, ALandscape* Landscape)
+	{
+		if (Work.UndoTiles.Num() == 0 || !GUndo)
+		{
+			return 0;
+		}
+
+		TArray<TWeakObjectPtr<UTexture2D>> Textures;
+		for (const FGrassLockedWeightmap& Weightmap : Work.Weightmaps)
+		{
+			Textures.Add(Weightmap.Texture);
+		}
+
+		TUniquePtr<FGrassWeightmapChange> Change =
+			MakeUnique<FGrassWeightmapChange>(MoveTemp(Textures), MoveTemp(Work.UndoTiles));
+
+		const SIZE_T RecordSize = Change->GetRecordSize();
+		UE_LOG(LogGrassPlugin, Verbose, TEXT("Undo record for '%s': %d changed tile(s), %llu bytes from %llu raw."),
+			*Landscape->GetName(), Change->GetTileCount(), static_cast<uint64>(RecordSize),
+			static_cast<uint64>(Change->GetRawSize()));
+
+		GUndo->StoreUndo(Landscape, MoveTemp(Change));
+		return RecordSize;
+	}
+
+	/** Unlocks and re-uploads every weightmap LockGrassTextures locked. Game thread only. */
+	void UnlockGrassTextures(FGrassLandscapeWork& Work)
+	{
+		for (const FGrassLockedWeightmap& Weightmap : Work.Weightmaps)
+		{
+			Weightmap.Texture->GetPlatformData()->Mips[0].BulkData.Unlock();
+			Weightmap.Texture->UpdateResource();
+		}
+
+		Work.Weightmaps.Reset();
+	}
+
+	/**
+	 * Single-thread throughput of FillGrassRegions under Rules, in texels per second, measured by
+	 * running it over a scratch weightmap whose grass channel starts empty - the worst case, where
+	 * every tile changes and is recorded for undo. No terrain is built for it, so neither the
+	 * terrain gather nor the slope limit is in the figure. Measured once per session for each set
+	 * of rules; it only feeds the plan's estimate. Game thread only.
+	 */
+	double MeasureFillTexelsPerSecond(const FGrassWeightRules& Rules)
+	{
+		FXxHash64Builder Builder;
+		Rules.AppendToHash(Builder);
+		const uint64 RulesHash = Builder.Finalize().Hash;
+
+		static TMap<uint64, double> MeasuredTexelsPerSecond;
+		if (const double* Measured = MeasuredTexelsPerSecond.Find(RulesHash))
+		{
+			return *Measured;
+		}
+
+		constexpr int32 ScratchSize = 256;
+		constexpr int32 MaxRuns = 64;
+		constexpr double MinMeasuredSeconds = 0.02;
+
+		TArray<FColor> Pixels;
+		Pixels.SetNumZeroed(ScratchSize * ScratchSize);
+
+		FGrassLandscapeWork Work;
+		FGrassLockedWeightmap& Weightmap = Work.Weightmaps.AddDefaulted_GetRef();
+		Weightmap.Pixels = Pixels.GetData();
+		Weightmap.Size = FIntPoint(ScratchSize, ScratchSize);
+
+		FGrassWeightmapRegion& Region = Work.Regions.AddDefaulted_GetRef();
+		Region.WeightmapIndex = 0;
+		Region.Rect = FIntRect(0, 0, ScratchSize, ScratchSize);
+		Region.ChannelOffset = GrassKernels::GetChannelOffset(0);
+		// Two subsections across, so the noise is evaluated per vertex as in a real component.
+		Region.SubsectionSizeQuads = ScratchSize / 2 - 1;
+
+		double MeasuredSeconds = 0.0;
+		int32 Runs = 0;
+		while (Runs < MaxRuns && MeasuredSeconds < MinMeasuredSeconds)
+		{
+			FMemory::Memzero(Pixels.GetData(), Pixels.Num() * sizeof(FColor));
+			Work.UndoTiles.Reset();
+
+			const double RunStart = FPlatformTime::Seconds();
+			FillGrassRegions(Work, Rules, nullptr);
+			MeasuredSeconds += FPlatformTime::Seconds() - RunStart;
+			++Runs;
+		}
+
+		const double TexelsPerSecond = static_cast<double>(Runs) * Pixels.Num() / FMath::Max(MeasuredSeconds, UE_DOUBLE_SMALL_NUMBER);
+		MeasuredTexelsPerSecond.Add(RulesHash, TexelsPerSecond);
+		return TexelsPerSecond;
+	}
+
+	/** One landscape's virtual texture volume, between spawning it and placing it. */
+	struct FGrassVolumeWork
+	{
+		ALandscape* Landscape = nullptr;
+		ARuntimeVirtualTextureVolume* Volume = nullptr;
+		FQuat Rotation = FQuat::Identity;
+		FTransform LocalTransform;
+
+		/**
+		 * Bounds of every primitive writing into the virtual texture, in the landscape's frame:
+		 * each computed by CalcBounds on the game thread, empty ones left out.
+		 */
+		TArray<FBox> WriterBounds;
+
+		// Snap inputs, read on the game thread. bSnapToLandscape is false when the volume does
+		// not snap or the landscape has no info to snap to.
+		bool bSnapToLandscape = false;
+		FTransform LandscapeTransform;
+		FIntPoint LandscapeSize = FIntPoint::ZeroValue;
+
+		/** Output of the concurrent stage. */
+		FTransform VolumeTransform;
+	};
+
+	/**
+	 * Grows Work's volume to cover every writer, then snaps it to the landscape's texel grid.
+	 * Reads only the bounds and transforms gathered on the game thread, never the components
+	 * themselves; safe to run concurrently per landscape.
 	 */
-	uint8 FColor::* GetWeightmapChannelMember(uint8 ChannelIndex)
+	void ComputeVolumeTransform(FGrassVolumeWork& Work, int32 VirtualTextureSize)
 	{
-		switch (ChannelIndex)
+		FBox Bounds(ForceInit);
+		for (const FBox& WriterBounds : Work.WriterBounds)
 		{
-		case 0:  return &FColor::R;
-		case 1:  return &FColor::G;
-		case 2:  return &FColor::B;
-		case 3:  return &FColor::A;
-		default: return nullptr;
+			Bounds += WriterBounds;
+		}
+
+		FTransform VolumeTransform(
+			Work.Rotation, Work.LocalTransform.TransformPosition(Bounds.Min), Bounds.GetSize());
+
+		if (Work.bSnapToLandscape)
+		{
+			const FVector LandscapeScale = Work.LandscapeTransform.GetScale3D();
+			const int32 TexelsPerVertex = GrassKernels::GetVirtualTextureTexelsPerVertex(
+				Work.LandscapeSize.X, Work.LandscapeSize.Y, VirtualTextureSize);
+			const FVector TexelWorldSize = LandscapeScale / static_cast<float>(TexelsPerVertex);
+
+			VolumeTransform.SetScale3D(FVector(
+				(TexelWorldSize * static_cast<float>(VirtualTextureSize)).X,
+				(TexelWorldSize * static_cast<float>(VirtualTextureSize)).Y,
+				VolumeTransform.GetScale3D().Z));
+
+			// Snap onto the landscape's texel grid so the virtual texture is not sampled half a
+			// texel off.
+			const FVector BasePosition = VolumeTransform.GetTranslation();
+			const FVector LandscapeOrigin = Work.LandscapeTransform.GetTranslation();
+
+			const double SnapOffsetX = GrassKernels::GetTexelSnapOffset(BasePosition.X, LandscapeOrigin.X, TexelWorldSize.X);
+			const double SnapOffsetY = GrassKernels::GetTexelSnapOffset(BasePosition.Y, LandscapeOrigin.Y, TexelWorldSize.Y);
+
+			VolumeTransform.SetTranslation(BasePosition - FVector(SnapOffsetX, SnapOffsetY, 0.0f));
 		}
+
+		Work.VolumeTransform = VolumeTransform;
 	}
 #endif
 }
@@ -87,6 +501,13 @@ AGrassGenerator::AGrassGenerator()
 	, GrassLayerName(DefaultGrassLayerName)
 	, OtherLayerName(DefaultOtherLayerName)
 	, LayerInfoPackageRoot(DefaultLayerInfoPackageRoot)
+	, MaxGrassSlope(DefaultMaxGrassSlope)
+	, GrassNoiseStrength(DefaultGrassNoiseStrength)
+	, GrassNoiseSeed(DefaultGrassNoiseSeed)
+	, GrassNoiseScale(DefaultGrassNoiseScale)
+	, GrassNoiseOctaves(DefaultGrassNoiseOctaves)
+	, bUseWeightCache(false)
+	, WeightCacheSizeLimit(DefaultWeightCacheSizeLimit)
 	, bAutoGenerateOnConstruction(false)
 	, LandscapeSettleDelay(DefaultLandscapeSettleDelay)
 {
@@ -119,6 +540,7 @@ void AGrassGenerator::EndPlay(const EEndPlayReason::Type EndPlayReason)
 void AGrassGenerator::Destroyed()
 {
 	CancelPendingWork();
+	FGrassLandscapeTerrain::ReleaseAll();
 	Super::Destroyed();
 }
 
@@ -175,41 +597,193 @@ void AGrassGenerator::GenerateGrass()
 		return;
 	}
 
-	ApplyLandscapeMaterials();
+	// Shared rather than a member: each deferred pass holds it until it has run, and pressing the
+	// button again builds a fresh plan rather than changing the one a pending pass is reading.
+	const TSharedRef<FGrassGenerationPlan> Plan = MakeShared<FGrassGenerationPlan>();
+	BuildGenerationPlan(*Plan);
+	Plan->Log();
 
-	// Scheduled once, not once per landscape. Both passes iterate every landscape themselves,
+	if (Plan->Landscapes.Num() == 0)
+	{
+		UE_LOG(LogGrassPlugin, Warning, TEXT("No landscape actors found in this level."));
+		return;
+	}
+
+	ApplyLandscapeMaterials(*Plan);
+
+	// Scheduled once, not once per landscape. Both passes iterate every planned landscape themselves,
 	// so scheduling them inside the landscape loop ran the whole job N times over for N
 	// landscapes - and left N-1 uncancellable timers behind.
 	TWeakObjectPtr<AGrassGenerator> WeakThis(this);
 	FTimerManager& TimerManager = World->GetTimerManager();
 
-	TimerManager.SetTimer(VirtualTextureVolumeTimer, [WeakThis]()
+	TimerManager.SetTimer(VirtualTextureVolumeTimer, [WeakThis, Plan]()
 	{
 		if (AGrassGenerator* Self = WeakThis.Get())
 		{
-			Self->SetupVirtualTextureVolume();
+			Self->SetupVirtualTextureVolume(*Plan);
 		}
 	}, LandscapeSettleDelay, false);
 
-	TimerManager.SetTimer(LayerInfoTimer, [WeakThis]()
+	TimerManager.SetTimer(LayerInfoTimer, [WeakThis, Plan]()
 	{
 		if (AGrassGenerator* Self = WeakThis.Get())
 		{
-			Self->SetupLayerInfos();
+			Self->SetupLayerInfos(Plan);
 		}
 	}, LandscapeSettleDelay, false);
 }
 
-void AGrassGenerator::ApplyLandscapeMaterials()
+void AGrassGenerator::PlanGrassGeneration()
 {
-	int32 LandscapeCount = 0;
+	if (!GetWorld())
+	{
+		return;
+	}
 
-	for (TActorIterator<ALandscape> It(GetWorld()); It; ++It)
+	if (!ResolveAssets())
+	{
+		UE_LOG(LogGrassPlugin, Error, TEXT("Grass generation plan aborted: required assets are missing."));
+		return;
+	}
+
+	FGrassGenerationPlan Plan;
+	BuildGenerationPlan(Plan);
+	Plan.Log();
+}
+
+void AGrassGenerator::BuildGenerationPlan(FGrassGenerationPlan& OutPlan) const
+{
+	UWorld* World = GetWorld();
+	if (!World)
+	{
+		return;
+	}
+
+	// The layers the landscapes will have once ApplyLandscapeMaterials has run, read from the
+	// material itself - the landscapes' own layer lists only catch up after the reassignment.
+	const TArray<FName> MaterialLayers = ALandscapeProxy::GetLayersFromMaterial(ResolvedLandscapeMaterial);
+	const bool bMaterialHasGrassLayer = MaterialLayers.Contains(GrassLayerName);
+
+	for (TActorIterator<ALandscape> It(World); It; ++It)
 	{
 		ALandscape* Landscape = *It;
-		++LandscapeCount;
 
-		if (Landscape->GetLandscapeMaterial() == ResolvedLandscapeMaterial)
+		FGrassLandscapePlan& LandscapePlan = OutPlan.Landscapes.AddDefaulted_GetRef();
+		LandscapePlan.Fill.Landscape = Landscape;
+		LandscapePlan.bAssignMaterial = (Landscape->GetLandscapeMaterial() != ResolvedLandscapeMaterial);
+		LandscapePlan.bHasGrassLayer = bMaterialHasGrassLayer;
+
+		// As in SetupLayerInfos: only the grass and other layers get a layer info, and only where
+		// the landscape has none yet. GetOrCreateLayerInfo loads rather than creates when the
+		// package is already on disk, so those are not counted as saves.
+		const ULandscapeInfo* LandscapeInfo = Landscape->GetLandscapeInfo();
+		for (const FName LayerName : MaterialLayers)
+		{
+			if (LayerName != GrassLayerName && LayerName != OtherLayerName)
+			{
+				continue;
+			}
+
+			const FLandscapeInfoLayerSettings* LayerSettings = LandscapeInfo
+				? LandscapeInfo->Layers.FindByPredicate([LayerName](const FLandscapeInfoLayerSettings& Settings)
+				{
+					return Settings.LayerName == LayerName;
+				})
+				: nullptr;
+
+			if (LayerSettings && LayerSettings->LayerInfoObj)
+			{
+				if (LayerName == GrassLayerName)
+				{
+					LandscapePlan.Fill.GrassLayerInfo = LayerSettings->LayerInfoObj;
+				}
+				continue;
+			}
+
+			if (!FPackageName::DoesPackageExist(GetLayerInfoPackageName(LayerName)))
+			{
+				OutPlan.LayerInfosToCreate.AddUnique(LayerName);
+			}
+		}
+
+		TArray<ULandscapeComponent*> LandscapeComponents;
+		Landscape->GetComponents(LandscapeComponents);
+		LandscapePlan.ComponentCount = LandscapeComponents.Num();
+
+		if (!bMaterialHasGrassLayer)
+		{
+			continue;
+		}
+
+		TSet<const UTexture2D*> AllocatedWeightmaps;
+		for (ULandscapeComponent* Component : LandscapeComponents)
+		{
+			if (!Component)
+			{
+				continue;
+			}
+
+			const int64 ComponentTexels = (Component->SubsectionSizeQuads + 1) * Component->NumSubsections;
+			LandscapePlan.TexelsToWrite += ComponentTexels * ComponentTexels;
+
+			// Matched by object when the landscape already has a grass layer info, so an allocation
+			// of another layer info with the same name counts as missing, as it will in
+			// SetupLayerInfos. Otherwise by name: the layer info may not exist until then.
+			const ULandscapeLayerInfoObject* KnownGrassLayerInfo = LandscapePlan.Fill.GrassLayerInfo.Get();
+			const FWeightmapLayerAllocationInfo* Allocation = Component->GetWeightmapLayerAllocations().FindByPredicate(
+				[this, KnownGrassLayerInfo](const FWeightmapLayerAllocationInfo& Candidate)
+				{
+					return KnownGrassLayerInfo
+						? Candidate.LayerInfo == KnownGrassLayerInfo
+						: Candidate.LayerInfo && Candidate.LayerInfo->LayerName == GrassLayerName;
+				});
+
+			const TArray<UTexture2D*>& WeightmapTextures = Component->GetWeightmapTextures();
+			if (Allocation && WeightmapTextures.IsValidIndex(Allocation->WeightmapTextureIndex))
+			{
+				AllocatedWeightmaps.Add(WeightmapTextures[Allocation->WeightmapTextureIndex]);
+			}
+			else
+			{
+				LandscapePlan.ComponentsToAllocate.Add(Component);
+			}
+		}
+
+		LandscapePlan.WeightmapsToWrite = AllocatedWeightmaps.Num() + LandscapePlan.ComponentsToAllocate.Num();
+	}
+
+	bool bHasVirtualTextureVolume = false;
+	for (TActorIterator<ARuntimeVirtualTextureVolume> It(World); It; ++It)
+	{
+		bHasVirtualTextureVolume = true;
+		break;
+	}
+
+	OutPlan.Rules.GrassLayerName = GrassLayerName;
+	OutPlan.Rules.OtherLayerName = OtherLayerName;
+	OutPlan.Rules.GrassWeight = FullLayerWeight;
+	OutPlan.Rules.MaxSlope = GrassKernels::EncodeSlope(MaxGrassSlope);
+	OutPlan.Rules.NoiseStrength = FMath::RoundToInt(FMath::Clamp(GrassNoiseStrength, 0.0f, 1.0f) * GrassKernels::NoiseOne);
+	OutPlan.Rules.Noise.Seed = static_cast<uint32>(GrassNoiseSeed);
+	OutPlan.Rules.Noise.Frequency = static_cast<uint32>(
+		FMath::Clamp(FMath::RoundToInt(GrassKernels::NoiseOne / FMath::Max(GrassNoiseScale, MinGrassNoiseScale)), 1, GrassKernels::MaxNoiseFrequency));
+	OutPlan.Rules.Noise.Octaves = FMath::Clamp(GrassNoiseOctaves, 1, GrassKernels::MaxNoiseOctaves);
+
+	OutPlan.VirtualTextureVolumesToSpawn = bHasVirtualTextureVolume ? 0 : OutPlan.Landscapes.Num();
+	OutPlan.FillTexelsPerSecond = MeasureFillTexelsPerSecond(OutPlan.Rules);
+	OutPlan.Concurrency = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+
+	// The layer info timer, then the fill timer it schedules.
+	OutPlan.SettleSeconds = 2.0 * LandscapeSettleDelay;
+}
+
+void AGrassGenerator::ApplyLandscapeMaterials(const FGrassGenerationPlan& Plan)
+{
+	for (const FGrassLandscapePlan& LandscapePlan : Plan.Landscapes)
+	{
+		ALandscape* Landscape = LandscapePlan.Fill.Landscape.Get();
+		if (!Landscape || !LandscapePlan.bAssignMaterial)
 		{
 			continue;
 		}
@@ -226,14 +800,9 @@ void AGrassGenerator::ApplyLandscapeMaterials()
 
 		UE_LOG(LogGrassPlugin, Log, TEXT("Assigned landscape material to '%s'."), *Landscape->GetName());
 	}
-
-	if (LandscapeCount == 0)
-	{
-		UE_LOG(LogGrassPlugin, Warning, TEXT("No landscape actors found in this level."));
-	}
 }
 
-void AGrassGenerator::SetupLayerInfos()
+void AGrassGenerator::SetupLayerInfos(const TSharedRef<FGrassGenerationPlan>& Plan)
 {
 	UWorld* World = GetWorld();
 	if (!World)
@@ -241,14 +810,21 @@ void AGrassGenerator::SetupLayerInfos()
 		return;
 	}
 
-	for (TActorIterator<ALandscape> It(World); It; ++It)
+	bool bAnythingToFill = false;
+
+	for (FGrassLandscapePlan& LandscapePlan : Plan->Landscapes)
 	{
-		ALandscape* Landscape = *It;
+		ALandscape* Landscape = LandscapePlan.Fill.Landscape.Get();
+		if (!Landscape)
+		{
+			continue;
+		}
 
 		ULandscapeInfo* LandscapeInfo = Landscape->GetLandscapeInfo();
 		if (!LandscapeInfo)
 		{
 			UE_LOG(LogGrassPlugin, Warning, TEXT("'%s' has no landscape info yet; skipping."), *Landscape->GetName());
+			LandscapePlan.Fill.GrassLayerInfo.Reset();
 			continue;
 		}
 
@@ -301,6 +877,8 @@ void AGrassGenerator::SetupLayerInfos()
 			}
 		}
 
+		LandscapePlan.Fill.GrassLayerInfo = GrassLayerInfo;
+
 		if (!GrassLayerInfo)
 		{
 			UE_LOG(LogGrassPlugin, Warning, TEXT("No '%s' layer on landscape '%s'; nothing to fill."),
@@ -308,8 +886,14 @@ void AGrassGenerator::SetupLayerInfos()
 			continue;
 		}
 
-		// Make sure every component carries an allocation for the grass layer.
-		for (ULandscapeComponent* Component : Landscape->LandscapeComponents)
+		// Give every component without an allocation of this layer info object one. Every component
+		// is checked, not just the plan's list: the plan may have matched by name, and an
+		// allocation of a different layer info with the same name would otherwise be left as it
+		// is and never filled.
+		TArray<ULandscapeComponent*> LandscapeComponents;
+		Landscape->GetComponents(LandscapeComponents);
+
+		for (ULandscapeComponent* Component : LandscapeComponents)
 		{
 			if (!Component)
 			{
@@ -345,123 +929,155 @@ void AGrassGenerator::SetupLayerInfos()
 				*GrassLayerName.ToString(), *Component->GetName());
 		}
 
-		TWeakObjectPtr<AGrassGenerator> WeakThis(this);
-		TWeakObjectPtr<ALandscape> WeakLandscape(Landscape);
-		TWeakObjectPtr<ULandscapeLayerInfoObject> WeakGrassLayerInfo(GrassLayerInfo);
-
-		World->GetTimerManager().SetTimer(FillGrassTimer, [WeakThis, WeakLandscape, WeakGrassLayerInfo]()
-		{
-			AGrassGenerator* Self = WeakThis.Get();
-			ALandscape* TargetLandscape = WeakLandscape.Get();
-			ULandscapeLayerInfoObject* TargetLayerInfo = WeakGrassLayerInfo.Get();
-
-			// Weak throughout: the original captured the actor, the landscape and the layer
-			// info by raw pointer, any of which could be gone a second later.
-			if (Self && TargetLandscape && TargetLayerInfo)
-			{
-				Self->FillGrassLayer(TargetLandscape, TargetLayerInfo);
-			}
-		}, LandscapeSettleDelay, false);
+		bAnythingToFill = true;
 
 		Landscape->MarkPackageDirty();
 		Landscape->PostEditChange();
 		LandscapeInfo->UpdateAllComponentMaterialInstances();
 	}
+
+	if (!bAnythingToFill)
+	{
+		return;
+	}
+
+	// One timer for every landscape. The previous version re-armed the shared handle inside the
+	// landscape loop, which cancelled each pending fill in favour of the next - so only the last
+	// landscape was ever filled.
+	TWeakObjectPtr<AGrassGenerator> WeakThis(this);
+
+	World->GetTimerManager().SetTimer(FillGrassTimer, [WeakThis, Plan]()
+	{
+		// Weak throughout: the original captured the actor, the landscape and the layer info by
+		// raw pointer, any of which could be gone a second later. The plan holds the landscapes
+		// and layer infos weakly too, and FillGrassLayers re-checks them.
+		if (AGrassGenerator* Self = WeakThis.Get())
+		{
+			Self->FillGrassLayers(*Plan);
+		}
+	}, LandscapeSettleDelay, false);
 }
 
-void AGrassGenerator::FillGrassLayer(ALandscape* Landscape, ULandscapeLayerInfoObject* GrassLayerInfo)
+void AGrassGenerator::FillGrassLayers(FGrassGenerationPlan& Plan)
 {
+	const double PassStart = FPlatformTime::Seconds();
+	FGrassStageTimings Timings;
+	FGrassScratchPool::Get().BeginRun();
+
+	// The weightmaps are deliberately not Modify()'d: that would snapshot every texture in full.
+	// What changed goes into the transaction as one FGrassWeightmapChange per landscape instead.
 	const FScopedTransaction Transaction(NSLOCTEXT("GrassPlugin", "FillGrassLayer", "Fill Grass Layer"));
 
-	ULandscapeInfo* LandscapeInfo = Landscape->GetLandscapeInfo();
-	if (!LandscapeInfo)
+	// Weights that do not vary are cheaper to fill than to read back, so they skip the cache.
+	TUniquePtr<FGrassWeightTileCache> WeightCache;
+	if (bUseWeightCache && Plan.Rules.IsWorthCaching())
 	{
-		UE_LOG(LogGrassPlugin, Warning, TEXT("FillGrassLayer: '%s' has no landscape info."), *Landscape->GetName());
-		return;
+		WeightCache = MakeUnique<FGrassWeightTileCache>(
+			GetWeightCacheDirectory(), static_cast<int64>(WeightCacheSizeLimit) * 1024 * 1024);
 	}
 
-	Landscape->InvalidateGeneratedComponentData();
-	LandscapeInfo->UpdateAllComponentMaterialInstances();
+	// Game thread: everything that reads or writes the landscape, its components or its textures.
+	for (FGrassLandscapePlan& LandscapePlan : Plan.Landscapes)
+	{
+		FGrassLandscapeWork& Item = LandscapePlan.Fill;
+		ALandscape* Landscape = Item.Landscape.Get();
+		if (!Landscape || !Item.GrassLayerInfo.IsValid())
+		{
+			continue;
+		}
 
-	TArray<ULandscapeComponent*> LandscapeComponents;
-	Landscape->GetComponents(LandscapeComponents);
+		ULandscapeInfo* LandscapeInfo = Landscape->GetLandscapeInfo();
+		if (!LandscapeInfo)
+		{
+			UE_LOG(LogGrassPlugin, Warning, TEXT("FillGrassLayers: '%s' has no landscape info."), *Landscape->GetName());
+			continue;
+		}
 
-	int32 FilledComponents = 0;
+		Landscape->InvalidateGeneratedComponentData();
+		LandscapeInfo->UpdateAllComponentMaterialInstances();
+
+		LockGrassTextures(Item);
+
+		if (Plan.Rules.DependsOnTerrain())
+		{
+			Item.Terrain = FGrassLandscapeTerrain::FindOrAdd(Landscape);
+			Item.Terrain->Gather(Landscape);
+		}
+	}
+
+	// Nothing reads the terrain this run, so the tiles earlier runs kept go rather than wait for
+	// a slope limit that may never come back.
+	if (!Plan.Rules.DependsOnTerrain())
+	{
+		FGrassLandscapeTerrain::ReleaseAll();
+	}
+
+	// Concurrent: the pixel writes, and the terrain of whichever components the weight cache
+	// cannot serve - only those whose heights, or whose neighbours' heights, changed since the
+	// last run are decoded again. Landscapes share no weightmaps or terrain, so each task owns
+	// its locks outright and nothing here needs synchronising.
+	RunConcurrentLandscapeStage(Plan.Landscapes.Num(), [&Plan, &WeightCache](int32 Index)
+	{
+		FillGrassRegions(Plan.Landscapes[Index].Fill, Plan.Rules, WeightCache.Get());
+	}, Timings);
 
-	for (ULandscapeComponent* Component : LandscapeComponents)
+	// Game thread: nothing after this reads the heightmaps.
+	for (FGrassLandscapePlan& LandscapePlan : Plan.Landscapes)
 	{
-		if (!Component)
+		FGrassLandscapeWork& Item = LandscapePlan.Fill;
+		if (Item.Terrain)
 		{
-			continue;
+			Item.Terrain->Release();
+
+			const ALandscape* Landscape = Item.Landscape.Get();
+			Item.Terrain->LogStats(Landscape ? *Landscape->GetName() : TEXT("<gone>"));
 		}
+	}
 
-		for (const FWeightmapLayerAllocationInfo& Allocation : Component->GetWeightmapLayerAllocations(true))
+	// Game thread: record the undo data, release the locks, upload, and let each landscape pick
+	// up its new weights.
+	SIZE_T UndoBytes = 0;
+	for (FGrassLandscapePlan& LandscapePlan : Plan.Landscapes)
+	{
+		FGrassLandscapeWork& Item = LandscapePlan.Fill;
+		ALandscape* Landscape = Item.Landscape.Get();
+		if (Landscape)
 		{
-			if (Allocation.LayerInfo != GrassLayerInfo)
-			{
-				continue;
-			}
+			UndoBytes += StoreGrassUndo(Item, Landscape);
+		}
 
-			const TArray<UTexture2D*>& WeightmapTextures = Component->GetWeightmapTextures();
-			if (!WeightmapTextures.IsValidIndex(Allocation.WeightmapTextureIndex))
-			{
-				UE_LOG(LogGrassPlugin, Warning,
-					TEXT("FillGrassLayer: weightmap index %d is out of range on '%s'."),
-					Allocation.WeightmapTextureIndex, *Component->GetName());
-				continue;
-			}
+		UnlockGrassTextures(Item);
 
-			// Checked before the name is read from it; the previous version logged the texture
-			// name first and only then tested for null.
-			UTexture2D* WeightmapTexture = WeightmapTextures[Allocation.WeightmapTextureIndex];
-			if (!WeightmapTexture || !WeightmapTexture->GetPlatformData())
-			{
-				UE_LOG(LogGrassPlugin, Warning,
-					TEXT("FillGrassLayer: no platform data for the weightmap on '%s'."), *Component->GetName());
-				continue;
-			}
+		ULandscapeLayerInfoObject* GrassLayerInfo = Item.GrassLayerInfo.Get();
+		ULandscapeInfo* LandscapeInfo = Landscape ? Landscape->GetLandscapeInfo() : nullptr;
+		if (!LandscapeInfo || !GrassLayerInfo)
+		{
+			continue;
+		}
 
-			// The layer's channel comes from the allocation. Writing all four components - as
-			// the previous version did, despite a comment stating grass was on red - set every
-			// layer sharing this texture to full weight, not just grass.
-			uint8 FColor::* const ChannelMember = GetWeightmapChannelMember(Allocation.WeightmapTextureChannel);
-			if (!ChannelMember)
-			{
-				UE_LOG(LogGrassPlugin, Warning, TEXT("FillGrassLayer: unexpected weightmap channel %d on '%s'."),
-					Allocation.WeightmapTextureChannel, *Component->GetName());
-				continue;
-			}
+		Landscape->InvalidateGeneratedComponentData();
+		LandscapeInfo->UpdateAllComponentMaterialInstances();
 
-			FTexture2DMipMap& Mip = WeightmapTexture->GetPlatformData()->Mips[0];
-			FColor* Pixels = static_cast<FColor*>(Mip.BulkData.Lock(LOCK_READ_WRITE));
-			if (!Pixels)
-			{
-				Mip.BulkData.Unlock();
-				UE_LOG(LogGrassPlugin, Warning, TEXT("FillGrassLayer: could not lock the weightmap on '%s'."),
-					*Component->GetName());
-				continue;
-			}
+		UE_LOG(LogGrassPlugin, Log, TEXT("Filled the '%s' layer on %d of %d components of '%s'."),
+			*GrassLayerInfo->LayerName.ToString(), Item.Regions.Num(), Item.ComponentCount, *Landscape->GetName());
+	}
 
-			const int32 PixelCount = WeightmapTexture->GetSizeX() * WeightmapTexture->GetSizeY();
-			for (int32 PixelIndex = 0; PixelIndex < PixelCount; ++PixelIndex)
-			{
-				Pixels[PixelIndex].*ChannelMember = FullLayerWeight;
-			}
+	UE_LOG(LogGrassPlugin, Log, TEXT("Fill grass layers: %.1f KB of undo data added to the transaction."),
+		UndoBytes / 1024.0);
 
-			Mip.BulkData.Unlock();
-			WeightmapTexture->UpdateResource();
-			++FilledComponents;
-		}
+	if (WeightCache)
+	{
+		WeightCache->Trim();
+		WeightCache->LogStats();
 	}
 
-	Landscape->InvalidateGeneratedComponentData();
-	LandscapeInfo->UpdateAllComponentMaterialInstances();
+	FGrassScratchPool::Get().LogRunStats(TEXT("Fill grass layers"));
 
-	UE_LOG(LogGrassPlugin, Log, TEXT("Filled the '%s' layer on %d of %d components of '%s'."),
-		*GrassLayerInfo->LayerName.ToString(), FilledComponents, LandscapeComponents.Num(), *Landscape->GetName());
+	Timings.TotalSeconds = FPlatformTime::Seconds() - PassStart;
+	Timings.Log(TEXT("Fill grass layers"), Plan.Landscapes.Num());
 }
 
-void AGrassGenerator::SetupVirtualTextureVolume()
+void AGrassGenerator::SetupVirtualTextureVolume(const FGrassGenerationPlan& Plan)
 {
 	UWorld* World = GetWorld();
 	if (!World || !ResolvedLandscapeVirtualTexture)
@@ -469,18 +1085,39 @@ void AGrassGenerator::SetupVirtualTextureVolume()
 		return;
 	}
 
+	const double PassStart = FPlatformTime::Seconds();
+	FGrassStageTimings Timings;
+
 	const FScopedTransaction Transaction(
 		NSLOCTEXT("GrassPlugin", "CreateRVTVolume", "Create Runtime Virtual Texture Volume"));
 
-	for (TActorIterator<ARuntimeVirtualTextureVolume> It(World); It; ++It)
+	if (Plan.VirtualTextureVolumesToSpawn == 0)
 	{
 		UE_LOG(LogGrassPlugin, Log, TEXT("A runtime virtual texture volume already exists; leaving it in place."));
 		return;
 	}
 
-	for (TActorIterator<ALandscape> It(World); It; ++It)
+	// Every primitive writing into this virtual texture, gathered once: each landscape's volume
+	// covers all of them.
+	TArray<const UPrimitiveComponent*> Writers;
+	for (TObjectIterator<UPrimitiveComponent> ComponentIt; ComponentIt; ++ComponentIt)
 	{
-		ALandscape* Landscape = *It;
+		if (ComponentIt->GetRuntimeVirtualTextures().Contains(ResolvedLandscapeVirtualTexture))
+		{
+			Writers.Add(*ComponentIt);
+		}
+	}
+
+	// Game thread: spawn the volumes and read what the bounds and snap math need.
+	TArray<FGrassVolumeWork> VolumeWork;
+	for (const FGrassLandscapePlan& LandscapePlan : Plan.Landscapes)
+	{
+		ALandscape* Landscape = LandscapePlan.Fill.Landscape.Get();
+		if (!Landscape)
+		{
+			continue;
+		}
+
 		Landscape->Modify();
 
 		ARuntimeVirtualTextureVolume* Volume = World->SpawnActor<ARuntimeVirtualTextureVolume>();
@@ -494,80 +1131,77 @@ void AGrassGenerator::SetupVirtualTextureVolume()
 		Volume->VirtualTextureComponent->SetVirtualTexture(ResolvedLandscapeVirtualTexture);
 		Landscape->RuntimeVirtualTextures.Add(ResolvedLandscapeVirtualTexture);
 
-		const FQuat TargetRotation = Landscape->GetActorRotation().Quaternion();
-		const FTransform LocalTransform(TargetRotation, Landscape->GetActorLocation(), FVector::OneVector);
-		const FTransform WorldToLocal = LocalTransform.Inverse();
-
-		// Grow the volume to cover every primitive writing into this virtual texture.
-		FBox Bounds(ForceInit);
-		for (TObjectIterator<UPrimitiveComponent> ComponentIt; ComponentIt; ++ComponentIt)
+		FGrassVolumeWork& Work = VolumeWork.AddDefaulted_GetRef();
+		Work.Landscape = Landscape;
+		Work.Volume = Volume;
+		Work.Rotation = Landscape->GetActorRotation().Quaternion();
+		Work.LocalTransform = FTransform(Work.Rotation, Landscape->GetActorLocation(), FVector::OneVector);
+
+		// Bounded in the landscape's frame directly, not boxed in world space and re-boxed, which
+		// would grow them on a rotated landscape. CalcBounds reads component state, so it stays
+		// here rather than in the concurrent stage.
+		const FTransform WorldToLocal = Work.LocalTransform.Inverse();
+		for (const UPrimitiveComponent* Writer : Writers)
 		{
-			const TArray<URuntimeVirtualTexture*>& VirtualTextures = ComponentIt->GetRuntimeVirtualTextures();
-			if (!VirtualTextures.Contains(ResolvedLandscapeVirtualTexture))
-			{
-				continue;
-			}
-
-			const FBoxSphereBounds LocalSpaceBounds =
-				ComponentIt->CalcBounds(ComponentIt->GetComponentTransform() * WorldToLocal);
-
-			if (LocalSpaceBounds.GetBox().GetVolume() > 0.0f)
+			const FBox LocalBounds = Writer->CalcBounds(Writer->GetComponentTransform() * WorldToLocal).GetBox();
+			if (LocalBounds.GetVolume() > 0.0f)
 			{
-				Bounds += LocalSpaceBounds.GetBox();
+				Work.WriterBounds.Add(LocalBounds);
 			}
 		}
 
-		FTransform VolumeTransform(
-			TargetRotation, LocalTransform.TransformPosition(Bounds.Min), Bounds.GetSize());
-
-		if (Volume->VirtualTextureComponent->GetSnapBoundsToLandscape())
+		const ULandscapeInfo* LandscapeInfo = Landscape->GetLandscapeInfo();
+		if (Volume->VirtualTextureComponent->GetSnapBoundsToLandscape() && LandscapeInfo)
 		{
-			const ULandscapeInfo* LandscapeInfo = Landscape->GetLandscapeInfo();
-			if (LandscapeInfo)
-			{
-				const FVector LandscapeScale = Landscape->GetTransform().GetScale3D();
-
-				int32 MinX, MinY, MaxX, MaxY;
-				LandscapeInfo->GetLandscapeExtent(MinX, MinY, MaxX, MaxY);
+			int32 MinX, MinY, MaxX, MaxY;
+			LandscapeInfo->GetLandscapeExtent(MinX, MinY, MaxX, MaxY);
 
-				const FIntPoint LandscapeSize(MaxX - MinX + 1, MaxY - MinY + 1);
-				const int32 LandscapeSizeLog2 =
-					FMath::Max(FMath::CeilLogTwo(LandscapeSize.X), FMath::CeilLogTwo(LandscapeSize.Y));
-
-				const int32 VirtualTextureSize = ResolvedLandscapeVirtualTexture->GetSize();
-				const int32 VirtualTextureSizeLog2 = FMath::FloorLog2(VirtualTextureSize);
-
-				const int32 TexelsPerVertexLog2 = FMath::Max(VirtualTextureSizeLog2 - LandscapeSizeLog2, 0);
-				const int32 TexelsPerVertex = 1 << TexelsPerVertexLog2;
-				const FVector TexelWorldSize = LandscapeScale / static_cast<float>(TexelsPerVertex);
+			Work.bSnapToLandscape = true;
+			Work.LandscapeTransform = Landscape->GetTransform();
+			Work.LandscapeSize = FIntPoint(MaxX - MinX + 1, MaxY - MinY + 1);
+		}
+	}
 
-				VolumeTransform.SetScale3D(FVector(
-					(TexelWorldSize * static_cast<float>(VirtualTextureSize)).X,
-					(TexelWorldSize * static_cast<float>(VirtualTextureSize)).Y,
-					VolumeTransform.GetScale3D().Z));
+	// Concurrent: the union of the writers' bounds and the snap, per landscape.
+	const int32 VirtualTextureSize = ResolvedLandscapeVirtualTexture->GetSize();
+	RunConcurrentLandscapeStage(VolumeWork.Num(), [&VolumeWork, VirtualTextureSize](int32 Index)
+	{
+		ComputeVolumeTransform(VolumeWork[Index], VirtualTextureSize);
+	}, Timings);
 
-				// Snap onto the landscape's texel grid so the virtual texture is not sampled
-				// half a texel off.
-				const FVector BasePosition = VolumeTransform.GetTranslation();
-				const FVector SnapOrigin = Landscape->GetTransform().GetTranslation() - HalfTexel * TexelWorldSize;
+	// Game thread: place the volumes.
+	for (const FGrassVolumeWork& Work : VolumeWork)
+	{
+		Work.Volume->SetActorTransform(Work.VolumeTransform);
+		Work.Volume->VirtualTextureComponent->MarkRenderStateDirty();
 
-				const float SnapOffsetX = FMath::Frac((BasePosition.X - SnapOrigin.X) / TexelWorldSize.X) * TexelWorldSize.X;
-				const float SnapOffsetY = FMath::Frac((BasePosition.Y - SnapOrigin.Y) / TexelWorldSize.Y) * TexelWorldSize.Y;
+		UE_LOG(LogGrassPlugin, Log, TEXT("Runtime virtual texture volume aligned to '%s'."), *Work.Landscape->GetName());
+	}
 
-				VolumeTransform.SetTranslation(BasePosition - FVector(SnapOffsetX, SnapOffsetY, 0.0f));
-			}
-		}
+	Timings.TotalSeconds = FPlatformTime::Seconds() - PassStart;
+	Timings.Log(TEXT("Virtual texture volumes"), VolumeWork.Num());
+}
 
-		Volume->SetActorTransform(VolumeTransform);
-		Volume->VirtualTextureComponent->MarkRenderStateDirty();
+FString AGrassGenerator::GetLayerInfoPackageName(FName LayerName) const
+{
+	return FString::Printf(TEXT("%s/%s"), *LayerInfoPackageRoot, *LayerName.ToString());
+}
 
-		UE_LOG(LogGrassPlugin, Log, TEXT("Runtime virtual texture volume aligned to '%s'."), *Landscape->GetName());
+FString AGrassGenerator::GetWeightCacheDirectory() const
+{
+	if (WeightCacheDirectory.Path.IsEmpty())
+	{
+		return FPaths::ConvertRelativePathToFull(
+			FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("GrassPlugin"), TEXT("WeightCache")));
 	}
+
+	// Relative paths are taken from the project directory, as the directory picker writes them.
+	return FPaths::ConvertRelativePathToFull(FPaths::ProjectDir(), WeightCacheDirectory.Path);
 }
 
 ULandscapeLayerInfoObject* AGrassGenerator::GetOrCreateLayerInfo(FName LayerName, UPhysicalMaterial* PhysMaterial)
 {
-	const FString PackageName = FString::Printf(TEXT("%s/%s"), *LayerInfoPackageRoot, *LayerName.ToString());
+	const FString PackageName = GetLayerInfoPackageName(LayerName);
 	const FString AssetPath = FString::Printf(TEXT("%s.%s"), *PackageName, *LayerName.ToString());
 
 	if (ULandscapeLayerInfoObject* Existing = LoadObject<ULandscapeLayerInfoObject>(nullptr, *AssetPath))
@@ -659,4 +1293,9 @@ void AGrassGenerator::GenerateGrass()
 	UE_LOG(LogGrassPlugin, Warning, TEXT("GenerateGrass is an editor-only operation."));
 }
 
+void AGrassGenerator::PlanGrassGeneration()
+{
+	UE_LOG(LogGrassPlugin, Warning, TEXT("PlanGrassGeneration is an editor-only operation."));
+}
+
 #endif // WITH_EDITOR
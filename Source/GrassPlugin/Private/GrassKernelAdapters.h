@@ -0,0 +1,32 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kernels/GrassKernels.h"
+
+// The kernels address weightmaps as BGRA8 byte arrays. That is FColor's layout on every
+// platform Unreal ships, and the channel offsets they use depend on it - so it is checked here
+// rather than assumed.
+static_assert(sizeof(FColor) == GrassKernels::BytesPerTexel, "FColor is not four bytes.");
+static_assert(STRUCT_OFFSET(FColor, B) == 0 && STRUCT_OFFSET(FColor, G) == 1
+	&& STRUCT_OFFSET(FColor, R) == 2 && STRUCT_OFFSET(FColor, A) == 3,
+	"FColor is not laid out as BGRA8; GrassKernels::GetChannelOffset would address the wrong bytes.");
+
+namespace GrassKernels
+{
+	inline FTexelRect ToTexelRect(const FIntRect& Rect)
+	{
+		return FTexelRect{ Rect.Min.X, Rect.Min.Y, Rect.Max.X, Rect.Max.Y };
+	}
+
+	inline uint8* AsTexels(FColor* Pixels)
+	{
+		return reinterpret_cast<uint8*>(Pixels);
+	}
+
+	inline const uint8* AsTexels(const FColor* Pixels)
+	{
+		return reinterpret_cast<const uint8*>(Pixels);
+	}
+}
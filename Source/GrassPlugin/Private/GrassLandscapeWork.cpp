@@ -0,0 +1,46 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#include "GrassLandscapeWork.h"
+
+#include "Async/ParallelFor.h"
+#include "GrassPlugin.h"
+#include "HAL/PlatformTime.h"
+
+void FGrassStageTimings::Log(const TCHAR* PassName, int32 LandscapeCount) const
+{
+	UE_LOG(LogGrassPlugin, Log,
+		TEXT("%s: %.1f ms across %d landscape(s) - %.1f ms serial on the game thread, %.1f ms waiting on ")
+		TEXT("%.1f ms of concurrent work (%.1f ms overlapped)."),
+		PassName, TotalSeconds * 1000.0, LandscapeCount, GetSerialSeconds() * 1000.0,
+		WaitingSeconds * 1000.0, WorkSeconds * 1000.0, GetOverlappedSeconds() * 1000.0);
+}
+
+void RunConcurrentLandscapeStage(int32 Num, TFunctionRef<void(int32)> Stage, FGrassStageTimings& Timings)
+{
+	if (Num <= 0)
+	{
+		return;
+	}
+
+	// Written by index rather than accumulated, so the workers never contend on a shared total.
+	TArray<double> WorkSeconds;
+	WorkSeconds.SetNumZeroed(Num);
+
+	const double WaitStart = FPlatformTime::Seconds();
+
+	// Unbalanced: each index is a whole landscape, so there is nothing to gain from batching
+	// several into one task and a lot to lose if the large one lands in a batch.
+	ParallelFor(Num, [&Stage, &WorkSeconds](int32 Index)
+	{
+		const double WorkStart = FPlatformTime::Seconds();
+		Stage(Index);
+		WorkSeconds[Index] = FPlatformTime::Seconds() - WorkStart;
+	}, EParallelForFlags::Unbalanced);
+
+	Timings.WaitingSeconds += FPlatformTime::Seconds() - WaitStart;
+
+	for (const double Seconds : WorkSeconds)
+	{
+		Timings.WorkSeconds += Seconds;
+	}
+}
@@ -0,0 +1,112 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GrassWeightmapUndo.h"
+#include "Templates/Function.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+
+class ALandscape;
+class FGrassLandscapeTerrain;
+class ULandscapeLayerInfoObject;
+class UTexture2D;
+
+/**
+ * A weightmap texture whose top mip is locked for writing for the duration of a pass.
+ *
+ * Locked and unlocked on the game thread; only the pixels are touched from the concurrent
+ * stage in between.
+ */
+struct FGrassLockedWeightmap
+{
+	UTexture2D* Texture = nullptr;
+	FColor* Pixels = nullptr;
+	FIntPoint Size = FIntPoint::ZeroValue;
+};
+
+/** A heightmap texture whose top mip is locked for reading while the terrain cache is built. */
+struct FGrassLockedHeightmap
+{
+	UTexture2D* Texture = nullptr;
+	const FColor* Pixels = nullptr;
+	FIntPoint Size = FIntPoint::ZeroValue;
+};
+
+/** One component's footprint in a weightmap, and the channel the grass layer occupies there. */
+struct FGrassWeightmapRegion
+{
+	/** Index into FGrassLandscapeWork::Weightmaps. */
+	int32 WeightmapIndex = INDEX_NONE;
+
+	/** Texels the component covers. Max is exclusive. */
+	FIntRect Rect;
+
+	/** Byte offset of the grass layer's channel within a texel; see GrassKernels::GetChannelOffset. */
+	int32 ChannelOffset = INDEX_NONE;
+
+	/** The component's offset within the landscape, in quads; also finds its terrain tile. */
+	FIntPoint SectionBase = FIntPoint::ZeroValue;
+
+	/** Quads along a subsection's edge; see GrassKernels::GetWeightmapTexelVertex. */
+	int32 SubsectionSizeQuads = 0;
+};
+
+/**
+ * Everything one pass needs to know about one landscape.
+ *
+ * Separate ALandscape actors share no components and no weightmaps, so the CPU-heavy part of a
+ * pass can run for several of them at once. Each pass is split the same way: gather on the
+ * game thread (anything that reads or writes a UObject), a concurrent stage that works on
+ * plain memory only, then a commit on the game thread.
+ *
+ * The landscape and layer info are weak because the item outlives the timer that schedules
+ * the pass; the gathered fields are only valid between gather and commit.
+ */
+struct FGrassLandscapeWork
+{
+	TWeakObjectPtr<ALandscape> Landscape;
+	TWeakObjectPtr<ULandscapeLayerInfoObject> GrassLayerInfo;
+
+	TArray<FGrassLockedWeightmap> Weightmaps;
+	TArray<FGrassWeightmapRegion> Regions;
+	int32 ComponentCount = 0;
+
+	/**
+	 * The landscape's decoded terrain, gathered on the game thread. The concurrent stage hashes
+	 * it and builds only the tiles the weight cache cannot serve. Null when no weight rule reads
+	 * the terrain.
+	 */
+	TSharedPtr<FGrassLandscapeTerrain> Terrain;
+
+	/** What the concurrent stage changed, indexed against Weightmaps; becomes the undo record. */
+	TArray<FGrassWeightmapDeltaTile> UndoTiles;
+};
+
+/**
+ * Where the time in one pass went.
+ *
+ * "Waiting" is the wall time the game thread spent blocked on the concurrent stage; "work" is
+ * the sum of the per-landscape times inside it. The difference is what running landscapes
+ * side by side saved over running them one after another.
+ */
+struct FGrassStageTimings
+{
+	double TotalSeconds = 0.0;
+	double WaitingSeconds = 0.0;
+	double WorkSeconds = 0.0;
+
+	double GetOverlappedSeconds() const { return FMath::Max(0.0, WorkSeconds - WaitingSeconds); }
+	double GetSerialSeconds() const { return FMath::Max(0.0, TotalSeconds - WaitingSeconds); }
+
+	/** Writes a one-line summary to LogGrassPlugin. */
+	void Log(const TCHAR* PassName, int32 LandscapeCount) const;
+};
+
+/**
+ * Runs Stage once for every index in [0, Num), one landscape per task, and adds the waiting and
+ * work times to Timings. Blocks until every call has returned.
+ *
+ * Stage must not touch UObjects: it runs on worker threads.
+ */
+void RunConcurrentLandscapeStage(int32 Num, TFunctionRef<void(int32)> Stage, FGrassStageTimings& Timings);
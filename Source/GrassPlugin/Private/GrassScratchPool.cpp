@@ -0,0 +1,123 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#include "GrassScratchPool.h"
+
+#include "GrassPlugin.h"
+#include "Misc/ScopeLock.h"
+
+namespace
+{
+	/** A cache line, so two workers' buffers never share one, and wide enough for any vector load. */
+	constexpr uint32 ScratchAlignment = 64;
+}
+
+FGrassScratchArena::FGrassScratchArena(FGrassScratchPool& InPool)
+	: Pool(InPool)
+{
+}
+
+FGrassScratchArena::~FGrassScratchArena()
+{
+	for (FBuffer& Buffer : Buffers)
+	{
+		if (Buffer.Data)
+		{
+			FMemory::Free(Buffer.Data);
+			Pool.OnFreed(Buffer.Capacity);
+		}
+	}
+}
+
+TArrayView<uint8> FGrassScratchArena::Get(EGrassScratchBuffer Which, int32 Size)
+{
+	check(Which < EGrassScratchBuffer::Num && Size >= 0);
+	FBuffer& Buffer = Buffers[static_cast<int32>(Which)];
+
+	if (Size > Buffer.Capacity)
+	{
+		// Nothing to copy: the caller overwrites whatever it asked for.
+		if (Buffer.Data)
+		{
+			FMemory::Free(Buffer.Data);
+			Pool.OnFreed(Buffer.Capacity);
+		}
+
+		const int32 Capacity = Align(Size, ScratchAlignment);
+		Buffer.Data = static_cast<uint8*>(FMemory::Malloc(Capacity, ScratchAlignment));
+		Buffer.Capacity = Capacity;
+		Pool.OnAllocated(Capacity);
+	}
+
+	return TArrayView<uint8>(Buffer.Data, Size);
+}
+
+FGrassScratchPool& FGrassScratchPool::Get()
+{
+	static FGrassScratchPool Pool;
+	return Pool;
+}
+
+FGrassScratchPool::~FGrassScratchPool()
+{
+	FreeArenas.Reset();
+	Arenas.Reset();
+}
+
+FGrassScratchArena* FGrassScratchPool::Acquire()
+{
+	++Acquires;
+
+	FScopeLock ScopeLock(&Lock);
+	if (FreeArenas.Num() > 0)
+	{
+		return FreeArenas.Pop(false);
+	}
+
+	return Arenas.Add_GetRef(MakeUnique<FGrassScratchArena>(*this)).Get();
+}
+
+void FGrassScratchPool::Release(FGrassScratchArena* Arena)
+{
+	check(Arena);
+
+	FScopeLock ScopeLock(&Lock);
+	FreeArenas.Add(Arena);
+}
+
+void FGrassScratchPool::BeginRun()
+{
+	Allocations = 0;
+	Acquires = 0;
+	PeakBytes = CurrentBytes.load();
+}
+
+void FGrassScratchPool::LogRunStats(const TCHAR* PassName) const
+{
+	int32 ArenaCount = 0;
+	{
+		FScopeLock ScopeLock(&Lock);
+		ArenaCount = Arenas.Num();
+	}
+
+	UE_LOG(LogGrassPlugin, Log,
+		TEXT("%s: scratch peaked at %.1f KB across %d arena(s); %d allocation(s) for %d task(s) this run, %d since startup."),
+		PassName, PeakBytes.load() / 1024.0, ArenaCount, Allocations.load(), Acquires.load(), TotalAllocations.load());
+}
+
+void FGrassScratchPool::OnAllocated(int64 Bytes)
+{
+	++Allocations;
+	++TotalAllocations;
+
+	const int64 Current = CurrentBytes += Bytes;
+
+	int64 Peak = PeakBytes.load();
+	while (Current > Peak && !PeakBytes.compare_exchange_weak(Peak, Current))
+	{
+	}
+}
+
+void FGrassScratchPool::OnFreed(int64 Bytes)
+{
+	CurrentBytes -= Bytes;
+}
@@ -0,0 +1,124 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+
+#include <atomic>
+
+class FGrassScratchPool;
+
+/** The scratch buffers an arena holds, one of each. */
+enum class EGrassScratchBuffer : uint8
+{
+	/** A component's computed grass weights. */
+	Weights,
+	/** The grass channel of one tile as it was before the fill. */
+	Before,
+	/** The grass channel of one tile after the fill. */
+	After,
+	/** A tile's channel while it is being compressed. */
+	Compressed,
+
+	Num
+};
+
+/**
+ * One worker's scratch memory: a cache-line aligned buffer per EGrassScratchBuffer, grown to
+ * the largest size asked for and never shrunk. Contents do not survive from one Get to the
+ * next, so there is nothing to clear between components or runs.
+ *
+ * Used by one thread at a time; hand it around through FGrassScratchScope.
+ */
+class FGrassScratchArena
+{
+public:
+	explicit FGrassScratchArena(FGrassScratchPool& InPool);
+	~FGrassScratchArena();
+
+	UE_NONCOPYABLE(FGrassScratchArena);
+
+	/** Returns the Which buffer, grown to at least Size bytes if needed. Contents are undefined. */
+	TArrayView<uint8> Get(EGrassScratchBuffer Which, int32 Size);
+
+private:
+	struct FBuffer
+	{
+		uint8* Data = nullptr;
+		int32 Capacity = 0;
+	};
+
+	FGrassScratchPool& Pool;
+	FBuffer Buffers[static_cast<int32>(EGrassScratchBuffer::Num)];
+};
+
+/**
+ * Process-wide pool of scratch arenas.
+ *
+ * A worker takes an arena for the length of its task and returns it when done, so the pool
+ * holds one arena per task that was ever running at once - in practice one per worker thread -
+ * and every later component and every later run reuses them. Sized once from the component
+ * resolution, a pass over thousands of components allocates nothing after its first few.
+ *
+ * Acquire and Release may be called from any thread.
+ */
+class FGrassScratchPool
+{
+public:
+	static FGrassScratchPool& Get();
+
+	~FGrassScratchPool();
+
+	/** Takes a free arena, or makes one if every arena is in use. */
+	FGrassScratchArena* Acquire();
+
+	/** Hands Arena back for the next Acquire. */
+	void Release(FGrassScratchArena* Arena);
+
+	/** Starts a new run for the counters LogRunStats reports. Game thread only. */
+	void BeginRun();
+
+	/** Writes the peak scratch memory and allocation counts since BeginRun to LogGrassPlugin. */
+	void LogRunStats(const TCHAR* PassName) const;
+
+private:
+	friend class FGrassScratchArena;
+
+	/** Called by the arenas whenever a buffer is (re)allocated or freed. */
+	void OnAllocated(int64 Bytes);
+	void OnFreed(int64 Bytes);
+
+	mutable FCriticalSection Lock;
+	TArray<FGrassScratchArena*> FreeArenas;
+	TArray<TUniquePtr<FGrassScratchArena>> Arenas;
+
+	std::atomic<int64> CurrentBytes{0};
+	std::atomic<int64> PeakBytes{0};
+	std::atomic<int32> Allocations{0};
+	std::atomic<int32> TotalAllocations{0};
+	std::atomic<int32> Acquires{0};
+};
+
+/** Holds an arena from the pool for the enclosing scope. */
+class FGrassScratchScope
+{
+public:
+	FGrassScratchScope()
+		: Arena(FGrassScratchPool::Get().Acquire())
+	{
+	}
+
+	~FGrassScratchScope()
+	{
+		FGrassScratchPool::Get().Release(Arena);
+	}
+
+	UE_NONCOPYABLE(FGrassScratchScope);
+
+	FGrassScratchArena& operator*() const { return *Arena; }
+	FGrassScratchArena* operator->() const { return Arena; }
+
+private:
+	FGrassScratchArena* Arena;
+};
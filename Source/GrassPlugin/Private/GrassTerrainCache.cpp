@@ -0,0 +1,339 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#include "GrassTerrainCache.h"
+
+#include "Async/ParallelFor.h"
+#include "Engine/Texture2D.h"
+#include "GrassKernelAdapters.h"
+#include "GrassPlugin.h"
+#include "Hash/xxhash.h"
+#include "Landscape.h"
+#include "LandscapeComponent.h"
+#include "LandscapeDataAccess.h"
+
+namespace
+{
+	/** Mixed into every tile's input hash. Bump when BuildTile changes what it produces. */
+	constexpr uint32 TerrainTileVersion = 1;
+
+	TMap<TWeakObjectPtr<ALandscape>, TSharedRef<FGrassLandscapeTerrain>>& GetTerrainCaches()
+	{
+		static TMap<TWeakObjectPtr<ALandscape>, TSharedRef<FGrassLandscapeTerrain>> Caches;
+		return Caches;
+	}
+
+	/** The eight neighbours, in the fixed order their hashes are combined in. */
+	const FIntPoint NeighbourOffsets[] =
+	{
+		FIntPoint(-1, -1), FIntPoint(0, -1), FIntPoint(1, -1),
+		FIntPoint(-1,  0),                   FIntPoint(1,  0),
+		FIntPoint(-1,  1), FIntPoint(0,  1), FIntPoint(1,  1),
+	};
+}
+
+TSharedRef<FGrassLandscapeTerrain> FGrassLandscapeTerrain::FindOrAdd(ALandscape* Landscape)
+{
+	check(IsInGameThread());
+
+	TMap<TWeakObjectPtr<ALandscape>, TSharedRef<FGrassLandscapeTerrain>>& Caches = GetTerrainCaches();
+
+	for (auto It = Caches.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	const TWeakObjectPtr<ALandscape> Key(Landscape);
+	if (const TSharedRef<FGrassLandscapeTerrain>* Existing = Caches.Find(Key))
+	{
+		return *Existing;
+	}
+
+	return Caches.Add(Key, MakeShared<FGrassLandscapeTerrain>());
+}
+
+void FGrassLandscapeTerrain::ReleaseAll()
+{
+	check(IsInGameThread());
+	GetTerrainCaches().Empty();
+}
+
+void FGrassLandscapeTerrain::Gather(ALandscape* Landscape)
+{
+	check(Heightmaps.Num() == 0);
+
+	Sources.Reset();
+	SourceIndices.Reset();
+	ComponentSizeQuads = Landscape->ComponentSizeQuads;
+
+	const FVector LandscapeScale = Landscape->GetActorScale3D();
+	Scale.HeightToWorld = LANDSCAPE_ZSCALE * LandscapeScale.Z;
+	Scale.SpacingX = LandscapeScale.X;
+	Scale.SpacingY = LandscapeScale.Y;
+
+	TArray<ULandscapeComponent*> LandscapeComponents;
+	Landscape->GetComponents(LandscapeComponents);
+
+	TMap<UTexture2D*, int32> HeightmapIndices;
+	const int32 Vertices = ComponentSizeQuads + 1;
+
+	for (const ULandscapeComponent* Component : LandscapeComponents)
+	{
+		UTexture2D* HeightmapTexture = Component ? Component->GetHeightmap() : nullptr;
+		if (!HeightmapTexture || !HeightmapTexture->GetPlatformData())
+		{
+			continue;
+		}
+
+		int32 HeightmapIndex = INDEX_NONE;
+		if (const int32* LockedIndex = HeightmapIndices.Find(HeightmapTexture))
+		{
+			HeightmapIndex = *LockedIndex;
+		}
+		else
+		{
+			FTexture2DMipMap& Mip = HeightmapTexture->GetPlatformData()->Mips[0];
+			const FColor* Pixels = static_cast<const FColor*>(Mip.BulkData.LockReadOnly());
+			if (!Pixels)
+			{
+				Mip.BulkData.Unlock();
+				UE_LOG(LogGrassPlugin, Warning, TEXT("Terrain cache: could not read the heightmap of '%s'."),
+					*Component->GetName());
+				continue;
+			}
+
+			FGrassLockedHeightmap& Locked = Heightmaps.AddDefaulted_GetRef();
+			Locked.Texture = HeightmapTexture;
+			Locked.Pixels = Pixels;
+			Locked.Size = FIntPoint(Mip.SizeX, Mip.SizeY);
+
+			HeightmapIndex = Heightmaps.Num() - 1;
+			HeightmapIndices.Add(HeightmapTexture, HeightmapIndex);
+		}
+
+		const FIntPoint TextureSize = Heightmaps[HeightmapIndex].Size;
+		const FIntPoint Offset(
+			FMath::RoundToInt(Component->HeightmapScaleBias.Z * TextureSize.X),
+			FMath::RoundToInt(Component->HeightmapScaleBias.W * TextureSize.Y));
+
+		FIntRect HeightmapRect(Offset, Offset + FIntPoint(Vertices, Vertices));
+		HeightmapRect.Clip(FIntRect(FIntPoint::ZeroValue, TextureSize));
+		if (HeightmapRect.Size() != FIntPoint(Vertices, Vertices))
+		{
+			UE_LOG(LogGrassPlugin, Warning, TEXT("Terrain cache: the heightmap of '%s' does not cover the component."),
+				*Component->GetName());
+			continue;
+		}
+
+		FComponentSource& Source = Sources.AddDefaulted_GetRef();
+		Source.SectionBase = Component->GetSectionBase();
+		Source.HeightmapIndex = HeightmapIndex;
+		Source.HeightmapRect = HeightmapRect;
+
+		SourceIndices.Add(Source.SectionBase, Sources.Num() - 1);
+	}
+}
+
+void FGrassLandscapeTerrain::HashInputs()
+{
+	const int32 Vertices = ComponentSizeQuads + 1;
+
+	ParallelFor(Sources.Num(), [this](int32 Index)
+	{
+		FComponentSource& Source = Sources[Index];
+		const FGrassLockedHeightmap& Heightmap = Heightmaps[Source.HeightmapIndex];
+		const FIntRect& Rect = Source.HeightmapRect;
+
+		FXxHash64Builder Builder;
+		for (int32 Y = Rect.Min.Y; Y < Rect.Max.Y; ++Y)
+		{
+			const FColor* const Row = Heightmap.Pixels + static_cast<int64>(Y) * Heightmap.Size.X;
+			Builder.Update(Row + Rect.Min.X, Rect.Width() * sizeof(FColor));
+		}
+		Source.TexelHash = Builder.Finalize().Hash;
+	});
+
+	for (FComponentSource& Source : Sources)
+	{
+		// The border comes from the neighbours, so a neighbour's edit invalidates this tile too.
+		FXxHash64Builder Builder;
+		Builder.Update(&TerrainTileVersion, sizeof(TerrainTileVersion));
+		Builder.Update(&Vertices, sizeof(Vertices));
+		Builder.Update(&Scale, sizeof(Scale));
+		Builder.Update(&Source.TexelHash, sizeof(Source.TexelHash));
+		for (const FIntPoint& Offset : NeighbourOffsets)
+		{
+			const FComponentSource* Neighbour = FindNeighbour(Source, Offset.X, Offset.Y);
+			const uint64 NeighbourHash = Neighbour ? Neighbour->TexelHash : 0;
+			Builder.Update(&NeighbourHash, sizeof(NeighbourHash));
+		}
+		Source.InputHash = Builder.Finalize().Hash;
+	}
+
+	TilesBuilt = 0;
+}
+
+uint64 FGrassLandscapeTerrain::GetInputHash(const FIntPoint& SectionBase) const
+{
+	const int32* Index = SourceIndices.Find(SectionBase);
+	return Index ? Sources[*Index].InputHash : 0;
+}
+
+void FGrassLandscapeTerrain::Build(TConstArrayView<FIntPoint> SectionBases)
+{
+	TBitArray<> Requested(false, Sources.Num());
+	for (const FIntPoint& SectionBase : SectionBases)
+	{
+		if (const int32* Index = SourceIndices.Find(SectionBase))
+		{
+			Requested[*Index] = true;
+		}
+	}
+
+	// Tiles are carried over by section base: a current one as it is, a stale requested one so
+	// the rebuild reuses its allocations. Stale tiles nobody asked for, and components that are
+	// gone, are not carried over.
+	TArray<FGrassTerrainTile> NewTiles;
+	NewTiles.Reserve(Sources.Num());
+
+	TArray<TPair<int32, int32>> StaleTiles;
+	for (int32 Index = 0; Index < Sources.Num(); ++Index)
+	{
+		const FComponentSource& Source = Sources[Index];
+		const int32* OldIndex = TileIndices.Find(Source.SectionBase);
+		const bool bCurrent = OldIndex && Tiles[*OldIndex].InputHash == Source.InputHash;
+		if (!bCurrent && !Requested[Index])
+		{
+			continue;
+		}
+
+		FGrassTerrainTile& Tile = NewTiles.AddDefaulted_GetRef();
+		if (OldIndex)
+		{
+			Tile = MoveTemp(Tiles[*OldIndex]);
+		}
+
+		if (!bCurrent)
+		{
+			Tile.InputHash = Source.InputHash;
+			StaleTiles.Emplace(NewTiles.Num() - 1, Index);
+		}
+	}
+
+	ParallelFor(StaleTiles.Num(), [this, &NewTiles, &StaleTiles](int32 Index)
+	{
+		BuildTile(NewTiles[StaleTiles[Index].Key], Sources[StaleTiles[Index].Value]);
+	});
+
+	Tiles = MoveTemp(NewTiles);
+	TileIndices.Reset();
+	for (int32 Index = 0; Index < Tiles.Num(); ++Index)
+	{
+		TileIndices.Add(Tiles[Index].SectionBase, Index);
+	}
+
+	TilesBuilt += StaleTiles.Num();
+	TilesReused = Tiles.Num() - TilesBuilt;
+	TilesSkipped = Sources.Num() - Tiles.Num();
+}
+
+void FGrassLandscapeTerrain::Release()
+{
+	for (const FGrassLockedHeightmap& Heightmap : Heightmaps)
+	{
+		Heightmap.Texture->GetPlatformData()->Mips[0].BulkData.Unlock();
+	}
+
+	Heightmaps.Reset();
+	Sources.Reset();
+	SourceIndices.Reset();
+}
+
+const FGrassTerrainTile* FGrassLandscapeTerrain::FindTile(const FIntPoint& SectionBase) const
+{
+	const int32* Index = TileIndices.Find(SectionBase);
+	return Index ? &Tiles[*Index] : nullptr;
+}
+
+void FGrassLandscapeTerrain::LogStats(const TCHAR* LandscapeName) const
+{
+	SIZE_T HeldBytes = Tiles.GetAllocatedSize();
+	for (const FGrassTerrainTile& Tile : Tiles)
+	{
+		HeldBytes += Tile.Heights.GetAllocatedSize() + Tile.Normals.GetAllocatedSize() + Tile.Slopes.GetAllocatedSize();
+	}
+
+	UE_LOG(LogGrassPlugin, Log,
+		TEXT("Terrain cache for '%s': %d tile(s) rebuilt, %d unchanged, %d not needed, %.1f MB held."),
+		LandscapeName, TilesBuilt, TilesReused, TilesSkipped, HeldBytes / (1024.0 * 1024.0));
+}
+
+void FGrassLandscapeTerrain::BuildTile(FGrassTerrainTile& Tile, const FComponentSource& Source) const
+{
+	const int32 Vertices = ComponentSizeQuads + 1;
+	const int32 BorderedStride = Vertices + 2;
+
+	Tile.SectionBase = Source.SectionBase;
+	Tile.Vertices = Vertices;
+	Tile.Heights.SetNumUninitialized(BorderedStride * BorderedStride);
+	Tile.Normals.SetNumUninitialized(Vertices * Vertices);
+	Tile.Slopes.SetNumUninitialized(Vertices * Vertices);
+	uint16* const Heights = Tile.Heights.GetData();
+
+	const FGrassLockedHeightmap& Heightmap = Heightmaps[Source.HeightmapIndex];
+	GrassKernels::DecodeHeights(GrassKernels::AsTexels(Heightmap.Pixels), Heightmap.Size.X,
+		GrassKernels::ToTexelRect(Source.HeightmapRect), Heights + BorderedStride + 1, BorderedStride);
+
+	// Neighbouring components repeat their shared edge, so the sample one past this tile's edge
+	// is the neighbour's second row or column, not its first.
+	const auto FillBorderSample = [this, Heights, &Source, Vertices, BorderedStride](int32 X, int32 Y)
+	{
+		const int32 DeltaX = X < 0 ? -1 : (X >= Vertices ? 1 : 0);
+		const int32 DeltaY = Y < 0 ? -1 : (Y >= Vertices ? 1 : 0);
+
+		uint16 Height = 0;
+		if (const FComponentSource* Neighbour = FindNeighbour(Source, DeltaX, DeltaY))
+		{
+			const FGrassLockedHeightmap& NeighbourHeightmap = Heightmaps[Neighbour->HeightmapIndex];
+			const FIntPoint Texel = Neighbour->HeightmapRect.Min
+				+ FIntPoint(X - DeltaX * ComponentSizeQuads, Y - DeltaY * ComponentSizeQuads);
+
+			Height = GrassKernels::DecodeHeight(GrassKernels::AsTexels(
+				NeighbourHeightmap.Pixels + static_cast<int64>(Texel.Y) * NeighbourHeightmap.Size.X + Texel.X));
+		}
+		else
+		{
+			Height = GrassKernels::ExtrapolateBorderHeight(Heights, Vertices, X, Y);
+		}
+
+		Heights[(Y + 1) * BorderedStride + X + 1] = Height;
+	};
+
+	for (int32 X = -1; X <= Vertices; ++X)
+	{
+		FillBorderSample(X, -1);
+		FillBorderSample(X, Vertices);
+	}
+
+	for (int32 Y = 0; Y < Vertices; ++Y)
+	{
+		FillBorderSample(-1, Y);
+		FillBorderSample(Vertices, Y);
+	}
+
+	GrassKernels::ComputeNormalsAndSlopes(Heights, Vertices, Scale, Tile.Normals.GetData(), Tile.Slopes.GetData());
+}
+
+const FGrassLandscapeTerrain::FComponentSource* FGrassLandscapeTerrain::FindNeighbour(
+	const FComponentSource& Source, int32 DeltaX, int32 DeltaY) const
+{
+	if (DeltaX == 0 && DeltaY == 0)
+	{
+		return nullptr;
+	}
+
+	const int32* Index = SourceIndices.Find(Source.SectionBase + FIntPoint(DeltaX, DeltaY) * ComponentSizeQuads);
+	return Index ? &Sources[*Index] : nullptr;
+}
@@ -0,0 +1,129 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GrassLandscapeWork.h"
+#include "Kernels/GrassTerrainKernels.h"
+
+class ALandscape;
+
+/**
+ * One component's decoded terrain: heights with a one-vertex border taken from its neighbours,
+ * and the normal and slope of every vertex. See GrassTerrainKernels.h for the formats.
+ */
+struct FGrassTerrainTile
+{
+	FIntPoint SectionBase = FIntPoint::ZeroValue;
+
+	/** Samples along each edge: the component's quads plus one. */
+	int32 Vertices = 0;
+
+	/**
+	 * Hash of everything the tile was built from - the component's heightmap texels, its eight
+	 * neighbours' and the landscape scale. Anything computed from the tile can key on it.
+	 */
+	uint64 InputHash = 0;
+
+	/** (Vertices + 2) squared; sample (-1, -1) first. */
+	TArray<uint16> Heights;
+
+	/** Vertices squared. */
+	TArray<uint16> Normals;
+	TArray<uint8> Slopes;
+
+	/** Height at (X, Y), where X and Y run from -1 to Vertices. */
+	uint16 GetHeight(int32 X, int32 Y) const { return Heights[(Y + 1) * (Vertices + 2) + X + 1]; }
+};
+
+/**
+ * Decoded heights, normals and slopes for every component of one landscape, kept between
+ * generation runs so each pass that needs the terrain reads it here instead of decoding the
+ * heightmaps itself. About five bytes per vertex; held until ReleaseAll, the landscape goes
+ * away, or a run no longer needs it.
+ *
+ * Updated once per run, gather-build-release like the other passes: Gather locks the heightmaps
+ * on the game thread, HashInputs hashes every component's texels, Build rebuilds in parallel
+ * only the tiles a pass asks for whose inputs changed, and Release unlocks. Hashing first lets
+ * a pass key its own results on the terrain and skip decoding it wherever it already has them.
+ * Between runs, and between Release and the next Gather, the tiles are read-only and safe to
+ * read from any thread.
+ */
+class FGrassLandscapeTerrain
+{
+public:
+	/**
+	 * The terrain cache for Landscape, made on first use. Caches whose landscape no longer exists
+	 * are dropped here. Game thread only.
+	 */
+	static TSharedRef<FGrassLandscapeTerrain> FindOrAdd(ALandscape* Landscape);
+
+	/**
+	 * Drops every landscape's cache. Runs already holding one keep it until they finish. Game
+	 * thread only.
+	 */
+	static void ReleaseAll();
+
+	/** Locks every component's heightmap for reading. Game thread only. */
+	void Gather(ALandscape* Landscape);
+
+	/**
+	 * Hashes what each component's tile is built from - its heightmap texels, its eight
+	 * neighbours' and the landscape scale - without decoding anything. Touches the locked texels
+	 * only; runs on any thread, and fans out over components itself.
+	 */
+	void HashInputs();
+
+	/**
+	 * Hash of what the tile at SectionBase is built from, known before it is built, so anything
+	 * computed from the tile can key on it. 0 if the component had no readable heightmap. Valid
+	 * from HashInputs to Release.
+	 */
+	uint64 GetInputHash(const FIntPoint& SectionBase) const;
+
+	/**
+	 * Brings the tiles of the components at SectionBases up to date with what Gather locked,
+	 * rebuilding those whose inputs changed. Other tiles are kept while current and dropped once
+	 * stale, so FindTile never returns an outdated one. Call after HashInputs, as often as
+	 * needed before Release; same threading as HashInputs.
+	 */
+	void Build(TConstArrayView<FIntPoint> SectionBases);
+
+	/** Unlocks what Gather locked. Game thread only. */
+	void Release();
+
+	/** The current tile of the component at SectionBase, or null if none was built for it. */
+	const FGrassTerrainTile* FindTile(const FIntPoint& SectionBase) const;
+
+	/** Writes the last build's counters to LogGrassPlugin. */
+	void LogStats(const TCHAR* LandscapeName) const;
+
+private:
+	/** Where one component's heights are, between Gather and Release. */
+	struct FComponentSource
+	{
+		FIntPoint SectionBase = FIntPoint::ZeroValue;
+		int32 HeightmapIndex = INDEX_NONE;
+		FIntRect HeightmapRect;
+		uint64 TexelHash = 0;
+		uint64 InputHash = 0;
+	};
+
+	void BuildTile(FGrassTerrainTile& Tile, const FComponentSource& Source) const;
+
+	/** The neighbour of Source offset by (DeltaX, DeltaY) components, or null at the landscape's edge. */
+	const FComponentSource* FindNeighbour(const FComponentSource& Source, int32 DeltaX, int32 DeltaY) const;
+
+	TArray<FGrassLockedHeightmap> Heightmaps;
+	TArray<FComponentSource> Sources;
+	TMap<FIntPoint, int32> SourceIndices;
+	int32 ComponentSizeQuads = 0;
+	GrassKernels::FTerrainScale Scale;
+
+	TArray<FGrassTerrainTile> Tiles;
+	TMap<FIntPoint, int32> TileIndices;
+
+	int32 TilesBuilt = 0;
+	int32 TilesReused = 0;
+	int32 TilesSkipped = 0;
+};
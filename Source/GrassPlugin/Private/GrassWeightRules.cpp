@@ -0,0 +1,63 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#include "GrassWeightRules.h"
+
+#include "Containers/StringConv.h"
+#include "GrassLandscapeWork.h"
+#include "GrassTerrainCache.h"
+#include "Hash/xxhash.h"
+#include "Kernels/GrassKernels.h"
+#include "Kernels/GrassNoiseKernels.h"
+#include "Kernels/GrassTerrainKernels.h"
+
+namespace
+{
+	void AppendNameToHash(FXxHash64Builder& Builder, FName Name)
+	{
+		// UTF-8 with a terminator, so the bytes do not depend on TCHAR's width and adjacent names
+		// cannot run together.
+		const FTCHARToUTF8 Text(*Name.ToString().ToLower());
+		Builder.Update(Text.Get(), Text.Length() + 1);
+	}
+}
+
+void FGrassWeightRules::AppendToHash(FXxHash64Builder& Builder) const
+{
+	AppendNameToHash(Builder, GrassLayerName);
+	AppendNameToHash(Builder, OtherLayerName);
+	Builder.Update(&GrassWeight, sizeof(GrassWeight));
+	Builder.Update(&MaxSlope, sizeof(MaxSlope));
+	Builder.Update(&NoiseStrength, sizeof(NoiseStrength));
+
+	// Noise settings only count while the noise is on, so changing them with it off keeps the cache.
+	if (NoiseStrength > 0)
+	{
+		Builder.Update(&Noise.Seed, sizeof(Noise.Seed));
+		Builder.Update(&Noise.Frequency, sizeof(Noise.Frequency));
+		Builder.Update(&Noise.Octaves, sizeof(Noise.Octaves));
+		Builder.Update(&Noise.PeriodLog2, sizeof(Noise.PeriodLog2));
+	}
+}
+
+void EvaluateGrassWeights(
+	const FGrassWeightRules& Rules, const FGrassWeightmapRegion& Region, const FGrassTerrainTile* Terrain,
+	TArrayView<uint8> OutWeights)
+{
+	const FIntPoint Size = Region.Rect.Size();
+	check(OutWeights.Num() == Size.X * Size.Y);
+
+	GrassKernels::FillWeights(Rules.GrassWeight, OutWeights.Num(), OutWeights.GetData());
+
+	if (Terrain && Rules.DependsOnTerrain())
+	{
+		GrassKernels::ApplySlopeLimit(Terrain->Slopes.GetData(), Terrain->Vertices, Region.SubsectionSizeQuads,
+			Rules.MaxSlope, Size.X, Size.Y, OutWeights.GetData());
+	}
+
+	// Evaluated at the landscape's own vertex coordinates, so texels two components share agree.
+	if (Rules.NoiseStrength > 0)
+	{
+		GrassKernels::ModulateWeights(Rules.Noise, Rules.NoiseStrength, Region.SectionBase.X, Region.SectionBase.Y,
+			Region.SubsectionSizeQuads, Size.X, Size.Y, OutWeights.GetData());
+	}
+}
@@ -0,0 +1,61 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kernels/GrassNoiseKernels.h"
+
+struct FGrassTerrainTile;
+struct FGrassWeightmapRegion;
+struct FXxHash64Builder;
+
+/**
+ * The parameters the grass weight of a texel is computed from.
+ *
+ * Everything that changes what the fill writes belongs in here, because the weight tile cache
+ * keys on it: a parameter left out of AppendToHash is one whose change serves stale tiles.
+ */
+struct FGrassWeightRules
+{
+	FName GrassLayerName;
+	FName OtherLayerName;
+
+	/** Weight written wherever grass applies, in weightmap units. */
+	uint8 GrassWeight = 255;
+
+	/** Steepest slope grass grows on, in GrassKernels::EncodeSlope units. 255, vertical, is no limit. */
+	uint8 MaxSlope = 255;
+
+	/**
+	 * How far the noise lowers the weight where it is lowest, in GrassKernels::NoiseOne units:
+	 * NoiseOne takes it to zero. 0 turns the noise off.
+	 */
+	int32 NoiseStrength = 0;
+
+	/** The noise grass weight is modulated by. Ignored while NoiseStrength is 0. */
+	GrassKernels::FNoiseSettings Noise;
+
+	/** Whether any rule reads the terrain, so the weights change when the heights do. */
+	bool DependsOnTerrain() const { return MaxSlope < 255; }
+
+	/**
+	 * Whether the weights are worth caching. Without a terrain rule or noise they are a single
+	 * value, and filling it costs less than reading a cached tile back.
+	 */
+	bool IsWorthCaching() const { return DependsOnTerrain() || NoiseStrength > 0; }
+
+	/**
+	 * Feeds every field into Builder. Names are hashed by their text, not their FName index, so
+	 * keys agree between editor sessions and between machines.
+	 */
+	void AppendToHash(FXxHash64Builder& Builder) const;
+};
+
+/**
+ * Computes the grass weight of every texel of Region into OutWeights, row-major, which holds
+ * exactly Region.Rect.Area() of them. Terrain is the component's tile; without one, the rules
+ * that depend on the terrain are not applied.
+ */
+void EvaluateGrassWeights(
+	const FGrassWeightRules& Rules, const FGrassWeightmapRegion& Region, const FGrassTerrainTile* Terrain,
+	TArrayView<uint8> OutWeights);
@@ -0,0 +1,203 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#include "GrassWeightTileCache.h"
+
+#include "GrassPlugin.h"
+#include "HAL/FileManager.h"
+#include "Misc/Compression.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Guid.h"
+#include "Misc/Paths.h"
+
+namespace
+{
+	/** Extension of cached tiles; Trim only ever considers files carrying it. */
+	const TCHAR* const TileExtension = TEXT("gwt");
+
+	constexpr uint32 TileMagic = 0x54575247; // "GRWT"
+
+	/** Bump when the file layout changes. Old tiles then fail the header check and count as misses. */
+	constexpr uint32 TileFormatVersion = 1;
+
+	struct FTileHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		int32 SizeX;
+		int32 SizeY;
+		int32 CompressedSize;
+	};
+}
+
+FGrassWeightTileCache::FGrassWeightTileCache(FString InRootDirectory, int64 InSizeLimit)
+	: RootDirectory(MoveTemp(InRootDirectory))
+	, SizeLimit(InSizeLimit)
+{
+}
+
+FString FGrassWeightTileCache::GetTilePath(uint64 Key) const
+{
+	// Fanned out over 256 directories by the top byte, as the engine's own DDC does, so no one
+	// directory ends up holding every tile of a large map.
+	return FPaths::Combine(RootDirectory,
+		FString::Printf(TEXT("%02x"), static_cast<uint32>(Key >> 56)),
+		FString::Printf(TEXT("%016llx.%s"), Key, TileExtension));
+}
+
+bool FGrassWeightTileCache::Contains(uint64 Key) const
+{
+	return IFileManager::Get().FileExists(*GetTilePath(Key));
+}
+
+bool FGrassWeightTileCache::Get(uint64 Key, const FIntPoint& Size, TArrayView<uint8> OutWeights)
+{
+	check(OutWeights.Num() == Size.X * Size.Y);
+
+	const FString Path = GetTilePath(Key);
+
+	TArray<uint8> File;
+	if (!FFileHelper::LoadFileToArray(File, *Path, FILEREAD_Silent))
+	{
+		++Misses;
+		return false;
+	}
+
+	FTileHeader Header = {};
+	if (File.Num() >= static_cast<int32>(sizeof(Header)))
+	{
+		FMemory::Memcpy(&Header, File.GetData(), sizeof(Header));
+	}
+
+	const bool bHeaderValid = Header.Magic == TileMagic
+		&& Header.Version == TileFormatVersion
+		&& Header.SizeX == Size.X
+		&& Header.SizeY == Size.Y
+		&& Header.CompressedSize == File.Num() - static_cast<int32>(sizeof(Header));
+
+	if (!bHeaderValid || !FCompression::UncompressMemory(NAME_Zlib, OutWeights.GetData(), OutWeights.Num(),
+		File.GetData() + sizeof(Header), Header.CompressedSize))
+	{
+		// Truncated, from an older format, or a key collision on tile size. Removed so the next
+		// Put can replace it rather than leaving it to miss forever.
+		UE_LOG(LogGrassPlugin, Verbose, TEXT("Weight cache: discarding unreadable tile '%s'."), *Path);
+		IFileManager::Get().Delete(*Path, false, false, true);
+		++Misses;
+		return false;
+	}
+
+	// Marks the tile as recently used, which is the order Trim evicts in.
+	IFileManager::Get().SetTimeStamp(*Path, FDateTime::UtcNow());
+
+	++Hits;
+	BytesRead += File.Num();
+	return true;
+}
+
+void FGrassWeightTileCache::Put(uint64 Key, const FIntPoint& Size, TConstArrayView<uint8> Weights)
+{
+	check(Weights.Num() == Size.X * Size.Y);
+
+	const FString Path = GetTilePath(Key);
+	if (IFileManager::Get().FileExists(*Path))
+	{
+		return;
+	}
+
+	int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, Weights.Num());
+
+	TArray<uint8> File;
+	File.SetNumUninitialized(sizeof(FTileHeader) + CompressedSize);
+
+	if (!FCompression::CompressMemory(NAME_Zlib, File.GetData() + sizeof(FTileHeader), CompressedSize,
+		Weights.GetData(), Weights.Num()))
+	{
+		return;
+	}
+
+	const FTileHeader Header = { TileMagic, TileFormatVersion, Size.X, Size.Y, CompressedSize };
+	FMemory::Memcpy(File.GetData(), &Header, sizeof(Header));
+	File.SetNum(sizeof(FTileHeader) + CompressedSize);
+
+	IFileManager& FileManager = IFileManager::Get();
+	FileManager.MakeDirectory(*FPaths::GetPath(Path), true);
+
+	// Unique per writer, so two machines computing the same tile at once cannot interleave.
+	const FString TempPath = FString::Printf(TEXT("%s.%s.tmp"), *Path, *FGuid::NewGuid().ToString());
+	if (!FFileHelper::SaveArrayToFile(File, *TempPath))
+	{
+		return;
+	}
+
+	if (FileManager.Move(*Path, *TempPath, true, false, false, true))
+	{
+		BytesWritten += File.Num();
+	}
+	else
+	{
+		FileManager.Delete(*TempPath, false, false, true);
+	}
+}
+
+void FGrassWeightTileCache::Trim()
+{
+	if (SizeLimit <= 0)
+	{
+		return;
+	}
+
+	struct FCachedTile
+	{
+		FString Path;
+		int64 Size;
+		FDateTime LastUsed;
+	};
+
+	TArray<FCachedTile> Tiles;
+	int64 TotalSize = 0;
+
+	IFileManager& FileManager = IFileManager::Get();
+	FileManager.IterateDirectoryStatRecursively(*RootDirectory,
+		[&Tiles, &TotalSize](const TCHAR* Path, const FFileStatData& StatData)
+		{
+			if (!StatData.bIsDirectory && FPaths::GetExtension(Path) == TileExtension)
+			{
+				Tiles.Add({ Path, StatData.FileSize, StatData.ModificationTime });
+				TotalSize += StatData.FileSize;
+			}
+			return true;
+		});
+
+	if (TotalSize <= SizeLimit)
+	{
+		return;
+	}
+
+	Tiles.Sort([](const FCachedTile& A, const FCachedTile& B)
+	{
+		return A.LastUsed < B.LastUsed;
+	});
+
+	for (const FCachedTile& Tile : Tiles)
+	{
+		if (TotalSize <= SizeLimit)
+		{
+			break;
+		}
+
+		// Another user sharing the directory may have evicted it first; that still frees the space.
+		FileManager.Delete(*Tile.Path, false, false, true);
+		TotalSize -= Tile.Size;
+		++EvictedTiles;
+		EvictedBytes += Tile.Size;
+	}
+}
+
+void FGrassWeightTileCache::LogStats() const
+{
+	constexpr double BytesPerMegabyte = 1024.0 * 1024.0;
+
+	UE_LOG(LogGrassPlugin, Log,
+		TEXT("Weight cache '%s': %d hit(s), %d miss(es), %.1f MB read, %.1f MB written, %d tile(s) evicted (%.1f MB)."),
+		*RootDirectory, Hits.load(), Misses.load(), BytesRead.load() / BytesPerMegabyte,
+		BytesWritten.load() / BytesPerMegabyte, EvictedTiles, EvictedBytes / BytesPerMegabyte);
+}
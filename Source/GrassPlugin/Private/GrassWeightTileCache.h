@@ -0,0 +1,63 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include <atomic>
+
+/**
+ * Content-addressed, on-disk cache of computed grass weight tiles - a derived data cache for
+ * this plugin alone.
+ *
+ * A tile is one component's grass weights, keyed by a hash of everything they were computed
+ * from: where the component sits, the layer set and the weight rules, and - only while a rule
+ * reads the terrain - the raw heightmap texels of the component and its neighbours, and the
+ * landscape scale. Equal inputs give equal keys on any machine, so a directory shared between
+ * workstations or build machines lets each reuse what the others computed, without decoding
+ * any terrain for the tiles it finds.
+ *
+ * Get and Put may be called from any thread; each touches only its own file. Files are written
+ * under a temporary name and renamed into place, so a concurrent reader sees a whole tile or
+ * none. Trim runs on the game thread once a pass is done.
+ */
+class FGrassWeightTileCache
+{
+public:
+	/** SizeLimit is in bytes; 0 or less disables trimming. */
+	FGrassWeightTileCache(FString InRootDirectory, int64 InSizeLimit);
+
+	/**
+	 * Reads the tile for Key into OutWeights, which must hold Size.X by Size.Y bytes. Returns
+	 * false on a miss, or if the stored tile is a different size.
+	 */
+	bool Get(uint64 Key, const FIntPoint& Size, TArrayView<uint8> OutWeights);
+
+	/**
+	 * Whether a tile is stored under Key, without reading it or counting a hit or miss. A tile
+	 * found here can still miss in Get: it may be unreadable, or trimmed in between.
+	 */
+	bool Contains(uint64 Key) const;
+
+	/** Stores Weights, Size.X by Size.Y, under Key. A tile already present is left alone. */
+	void Put(uint64 Key, const FIntPoint& Size, TConstArrayView<uint8> Weights);
+
+	/** Deletes least recently used tiles until the cache is back under its size limit. */
+	void Trim();
+
+	/** Writes this run's counters to LogGrassPlugin. */
+	void LogStats() const;
+
+private:
+	FString GetTilePath(uint64 Key) const;
+
+	FString RootDirectory;
+	int64 SizeLimit;
+
+	std::atomic<int32> Hits{0};
+	std::atomic<int32> Misses{0};
+	std::atomic<int64> BytesRead{0};
+	std::atomic<int64> BytesWritten{0};
+	int32 EvictedTiles = 0;
+	int64 EvictedBytes = 0;
+};
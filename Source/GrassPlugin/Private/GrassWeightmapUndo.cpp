@@ -0,0 +1,197 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#include "GrassWeightmapUndo.h"
+
+#include "Engine/Texture2D.h"
+#include "GrassKernelAdapters.h"
+#include "GrassPlugin.h"
+#include "GrassScratchPool.h"
+#include "Misc/Compression.h"
+
+#if WITH_EDITOR
+#include "Landscape.h"
+#include "LandscapeInfo.h"
+#endif
+
+namespace
+{
+	/**
+	 * Compresses Channel into OutCompressed through Scratch's Compressed buffer, copied out at
+	 * its exact size rather than compressed into a worst-case allocation and shrunk, which
+	 * would cost a second allocation per tile.
+	 */
+	bool CompressChannel(TConstArrayView<uint8> Channel, FGrassScratchArena& Scratch, TArray<uint8>& OutCompressed)
+	{
+		int32 CompressedSize = FCompression::CompressMemoryBound(NAME_Zlib, Channel.Num());
+		const TArrayView<uint8> Compressed = Scratch.Get(EGrassScratchBuffer::Compressed, CompressedSize);
+
+		if (!FCompression::CompressMemory(NAME_Zlib, Compressed.GetData(), CompressedSize, Channel.GetData(), Channel.Num()))
+		{
+			return false;
+		}
+
+		OutCompressed = TArray<uint8>(Compressed.GetData(), CompressedSize);
+		return true;
+	}
+}
+
+namespace GrassWeightmapDelta
+{
+	void ForEachTile(const FIntRect& Rect, TFunctionRef<void(const FIntRect&)> Visit)
+	{
+		for (int32 TileY = Rect.Min.Y; TileY < Rect.Max.Y; TileY += TileSize)
+		{
+			for (int32 TileX = Rect.Min.X; TileX < Rect.Max.X; TileX += TileSize)
+			{
+				const FIntPoint TileMax(FMath::Min(TileX + TileSize, Rect.Max.X), FMath::Min(TileY + TileSize, Rect.Max.Y));
+				Visit(FIntRect(FIntPoint(TileX, TileY), TileMax));
+			}
+		}
+	}
+
+	bool RecordTile(
+		const FColor* Pixels, int32 Stride, const FIntRect& Rect, int32 ChannelOffset,
+		TConstArrayView<uint8> Before, FGrassScratchArena& Scratch, FGrassWeightmapDeltaTile& OutTile)
+	{
+		check(Before.Num() == Rect.Area());
+
+		const TArrayView<uint8> After = Scratch.Get(EGrassScratchBuffer::After, Before.Num());
+		GrassKernels::CaptureChannel(GrassKernels::AsTexels(Pixels), Stride, GrassKernels::ToTexelRect(Rect),
+			ChannelOffset, After.GetData());
+
+		// Re-running generation over an already-filled landscape lands here for every tile, and
+		// the resulting transaction holds nothing but its header.
+		if (FMemory::Memcmp(Before.GetData(), After.GetData(), Before.Num()) == 0)
+		{
+			return false;
+		}
+
+		TArray<uint8> CompressedBefore;
+		TArray<uint8> CompressedAfter;
+		if (!CompressChannel(Before, Scratch, CompressedBefore) || !CompressChannel(After, Scratch, CompressedAfter))
+		{
+			UE_LOG(LogGrassPlugin, Warning,
+				TEXT("Grass undo: could not compress the tile at (%d, %d); it is filled but cannot be undone."),
+				Rect.Min.X, Rect.Min.Y);
+			return false;
+		}
+
+		OutTile.Rect = Rect;
+		OutTile.ChannelOffset = ChannelOffset;
+		OutTile.CompressedBefore = MoveTemp(CompressedBefore);
+		OutTile.CompressedAfter = MoveTemp(CompressedAfter);
+		return true;
+	}
+}
+
+FGrassWeightmapChange::FGrassWeightmapChange(
+	TArray<TWeakObjectPtr<UTexture2D>> InWeightmaps, TArray<FGrassWeightmapDeltaTile> InTiles)
+	: Weightmaps(MoveTemp(InWeightmaps))
+	, Tiles(MoveTemp(InTiles))
+{
+	// Grouped by weightmap so each texture is locked once per apply.
+	Tiles.StableSort([](const FGrassWeightmapDeltaTile& A, const FGrassWeightmapDeltaTile& B)
+	{
+		return A.WeightmapIndex < B.WeightmapIndex;
+	});
+}
+
+void FGrassWeightmapChange::Apply(UObject* Object)
+{
+	WriteTiles(Object, true);
+}
+
+void FGrassWeightmapChange::Revert(UObject* Object)
+{
+	WriteTiles(Object, false);
+}
+
+FString FGrassWeightmapChange::ToString() const
+{
+	return FString::Printf(TEXT("Grass weightmap change (%d tiles, %llu bytes)"),
+		Tiles.Num(), static_cast<uint64>(GetRecordSize()));
+}
+
+SIZE_T FGrassWeightmapChange::GetRecordSize() const
+{
+	SIZE_T Size = sizeof(*this) + Weightmaps.GetAllocatedSize() + Tiles.GetAllocatedSize();
+	for (const FGrassWeightmapDeltaTile& Tile : Tiles)
+	{
+		Size += Tile.CompressedBefore.GetAllocatedSize() + Tile.CompressedAfter.GetAllocatedSize();
+	}
+	return Size;
+}
+
+SIZE_T FGrassWeightmapChange::GetRawSize() const
+{
+	SIZE_T Size = 0;
+	for (const FGrassWeightmapDeltaTile& Tile : Tiles)
+	{
+		Size += 2 * Tile.Rect.Area();
+	}
+	return Size;
+}
+
+void FGrassWeightmapChange::WriteTiles(UObject* Object, bool bAfter)
+{
+	FGrassScratchScope Scratch;
+
+	int32 TileIndex = 0;
+	while (TileIndex < Tiles.Num())
+	{
+		const int32 WeightmapIndex = Tiles[TileIndex].WeightmapIndex;
+		const int32 FirstTile = TileIndex;
+		while (TileIndex < Tiles.Num() && Tiles[TileIndex].WeightmapIndex == WeightmapIndex)
+		{
+			++TileIndex;
+		}
+
+		UTexture2D* Texture = Weightmaps.IsValidIndex(WeightmapIndex) ? Weightmaps[WeightmapIndex].Get() : nullptr;
+		if (!Texture || !Texture->GetPlatformData())
+		{
+			UE_LOG(LogGrassPlugin, Warning, TEXT("Grass undo: a weightmap this change touched no longer exists; skipping it."));
+			continue;
+		}
+
+		FTexture2DMipMap& Mip = Texture->GetPlatformData()->Mips[0];
+		FColor* Pixels = static_cast<FColor*>(Mip.BulkData.Lock(LOCK_READ_WRITE));
+		if (!Pixels)
+		{
+			Mip.BulkData.Unlock();
+			UE_LOG(LogGrassPlugin, Warning, TEXT("Grass undo: could not lock '%s'."), *Texture->GetName());
+			continue;
+		}
+
+		for (int32 Index = FirstTile; Index < TileIndex; ++Index)
+		{
+			const FGrassWeightmapDeltaTile& Tile = Tiles[Index];
+			const TArray<uint8>& Compressed = bAfter ? Tile.CompressedAfter : Tile.CompressedBefore;
+			const TArrayView<uint8> Channel = Scratch->Get(EGrassScratchBuffer::After, Tile.Rect.Area());
+
+			if (!FCompression::UncompressMemory(NAME_Zlib, Channel.GetData(), Channel.Num(),
+				Compressed.GetData(), Compressed.Num()))
+			{
+				UE_LOG(LogGrassPlugin, Warning, TEXT("Grass undo: a tile of '%s' could not be decompressed."),
+					*Texture->GetName());
+				continue;
+			}
+
+			GrassKernels::WriteChannel(GrassKernels::AsTexels(Pixels), Mip.SizeX,
+				GrassKernels::ToTexelRect(Tile.Rect), Tile.ChannelOffset, Channel.GetData(), Tile.Rect.Width());
+		}
+
+		Mip.BulkData.Unlock();
+		Texture->UpdateResource();
+	}
+
+#if WITH_EDITOR
+	if (ALandscape* Landscape = Cast<ALandscape>(Object))
+	{
+		Landscape->InvalidateGeneratedComponentData();
+		if (ULandscapeInfo* LandscapeInfo = Landscape->GetLandscapeInfo())
+		{
+			LandscapeInfo->UpdateAllComponentMaterialInstances();
+		}
+	}
+#endif
+}
@@ -0,0 +1,91 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/Change.h"
+#include "Templates/Function.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+
+class FGrassScratchArena;
+class UTexture2D;
+
+/**
+ * One tile of one weightmap channel that a pass changed, stored as the compressed channel
+ * before and after.
+ *
+ * Both are written back whole rather than applied as a difference, so undo restores the
+ * original even if something outside the undo history - edit layer regeneration, a texture
+ * rebuild - rewrote the texels since. A fill leaves the "after" channel nearly uniform, so it
+ * compresses to almost nothing.
+ */
+struct FGrassWeightmapDeltaTile
+{
+	/** Index of the weightmap within the pass that recorded it. */
+	int32 WeightmapIndex = INDEX_NONE;
+
+	/** Texels covered. Max is exclusive. */
+	FIntRect Rect;
+
+	/** Byte offset of the channel within a texel; see GrassKernels::GetChannelOffset. */
+	int32 ChannelOffset = INDEX_NONE;
+
+	TArray<uint8> CompressedBefore;
+	TArray<uint8> CompressedAfter;
+};
+
+namespace GrassWeightmapDelta
+{
+	/** Edge length, in texels, of the tiles a region is split into. */
+	constexpr int32 TileSize = 64;
+
+	/** Calls Visit for each TileSize-square tile of Rect, clipped to Rect. */
+	void ForEachTile(const FIntRect& Rect, TFunctionRef<void(const FIntRect&)> Visit);
+
+	/**
+	 * Compares the channel now in Pixels against Before, as captured by
+	 * GrassKernels::CaptureChannel, and fills OutTile with both compressed. Returns false,
+	 * leaving OutTile untouched, when the tile did not change or could not be compressed; the
+	 * latter is logged, as the tile is then missing from undo.
+	 *
+	 * Works in Scratch's After and Compressed buffers, so the only allocations are the tile's
+	 * own compressed bytes. Touches plain memory only; safe off the game thread.
+	 */
+	bool RecordTile(
+		const FColor* Pixels, int32 Stride, const FIntRect& Rect, int32 ChannelOffset,
+		TConstArrayView<uint8> Before, FGrassScratchArena& Scratch, FGrassWeightmapDeltaTile& OutTile);
+}
+
+/**
+ * Undo record for one landscape's grass fill.
+ *
+ * Holds only the tiles that changed, and only their grass channel, rather than the full
+ * weightmaps a Modify() on each texture would snapshot. Stored against the landscape with
+ * GUndo->StoreUndo, so it lives in the same transaction as the rest of the pass.
+ */
+class FGrassWeightmapChange : public FCommandChange
+{
+public:
+	FGrassWeightmapChange(TArray<TWeakObjectPtr<UTexture2D>> InWeightmaps, TArray<FGrassWeightmapDeltaTile> InTiles);
+
+	//~ Begin FCommandChange interface
+	virtual void Apply(UObject* Object) override;
+	virtual void Revert(UObject* Object) override;
+	virtual FString ToString() const override;
+	//~ End FCommandChange interface
+
+	/** Bytes this record holds in the undo buffer. */
+	SIZE_T GetRecordSize() const;
+
+	/** Bytes the changed tiles' channels, before and after, would take uncompressed, for comparison in the log. */
+	SIZE_T GetRawSize() const;
+
+	int32 GetTileCount() const { return Tiles.Num(); }
+
+private:
+	/** Writes every tile's before or after channel into its weightmap and tells the landscape. */
+	void WriteTiles(UObject* Object, bool bAfter);
+
+	TArray<TWeakObjectPtr<UTexture2D>> Weightmaps;
+	TArray<FGrassWeightmapDeltaTile> Tiles;
+};
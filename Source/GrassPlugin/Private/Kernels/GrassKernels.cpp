@@ -0,0 +1,113 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#include "GrassKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace GrassKernels
+{
+	namespace
+	{
+		/** Smallest N with (1 << N) >= Value; 0 for Value <= 1. */
+		int32_t CeilLog2(uint32_t Value)
+		{
+			int32_t Log2 = 0;
+			while (Log2 < 32 && (1ull << Log2) < Value)
+			{
+				++Log2;
+			}
+			return Log2;
+		}
+
+		/** Largest N with (1 << N) <= Value; 0 for Value <= 1. */
+		int32_t FloorLog2(uint32_t Value)
+		{
+			int32_t Log2 = 0;
+			while (Value > 1)
+			{
+				Value >>= 1;
+				++Log2;
+			}
+			return Log2;
+		}
+
+		const uint8_t* RowStart(const uint8_t* Texels, int32_t Stride, const FTexelRect& Rect, int32_t Y, int32_t ChannelOffset)
+		{
+			return Texels + (static_cast<int64_t>(Y) * Stride + Rect.MinX) * BytesPerTexel + ChannelOffset;
+		}
+
+		uint8_t* RowStart(uint8_t* Texels, int32_t Stride, const FTexelRect& Rect, int32_t Y, int32_t ChannelOffset)
+		{
+			return Texels + (static_cast<int64_t>(Y) * Stride + Rect.MinX) * BytesPerTexel + ChannelOffset;
+		}
+	}
+
+	int32_t GetChannelOffset(int32_t ChannelIndex)
+	{
+		// BGRA8: blue is the first byte of the texel, alpha the last.
+		switch (ChannelIndex)
+		{
+		case 0:  return 2;
+		case 1:  return 1;
+		case 2:  return 0;
+		case 3:  return 3;
+		default: return -1;
+		}
+	}
+
+	void FillWeights(uint8_t Weight, int64_t Count, uint8_t* OutWeights)
+	{
+		std::memset(OutWeights, Weight, static_cast<size_t>(Count));
+	}
+
+	void CaptureChannel(
+		const uint8_t* Texels, int32_t Stride, const FTexelRect& Rect, int32_t ChannelOffset, uint8_t* OutChannel)
+	{
+		const int32_t Width = Rect.Width();
+		for (int32_t Y = Rect.MinY; Y < Rect.MaxY; ++Y)
+		{
+			const uint8_t* Source = RowStart(Texels, Stride, Rect, Y, ChannelOffset);
+			for (int32_t X = 0; X < Width; ++X)
+			{
+				OutChannel[X] = Source[X * BytesPerTexel];
+			}
+			OutChannel += Width;
+		}
+	}
+
+	void WriteChannel(
+		uint8_t* Texels, int32_t Stride, const FTexelRect& Rect, int32_t ChannelOffset,
+		const uint8_t* Weights, int32_t WeightStride)
+	{
+		const int32_t Width = Rect.Width();
+		for (int32_t Y = Rect.MinY; Y < Rect.MaxY; ++Y)
+		{
+			uint8_t* Destination = RowStart(Texels, Stride, Rect, Y, ChannelOffset);
+			for (int32_t X = 0; X < Width; ++X)
+			{
+				Destination[X * BytesPerTexel] = Weights[X];
+			}
+			Weights += WeightStride;
+		}
+	}
+
+	int32_t GetVirtualTextureTexelsPerVertex(int32_t LandscapeSizeX, int32_t LandscapeSizeY, int32_t VirtualTextureSize)
+	{
+		const int32_t LandscapeSizeLog2 = std::max(
+			CeilLog2(static_cast<uint32_t>(std::max(LandscapeSizeX, 0))),
+			CeilLog2(static_cast<uint32_t>(std::max(LandscapeSizeY, 0))));
+
+		const int32_t VirtualTextureSizeLog2 = FloorLog2(static_cast<uint32_t>(std::max(VirtualTextureSize, 0)));
+
+		return 1 << std::max(VirtualTextureSizeLog2 - LandscapeSizeLog2, 0);
+	}
+
+	double GetTexelSnapOffset(double Position, double Origin, double TexelSize)
+	{
+		const double SnapOrigin = Origin - HalfTexel * TexelSize;
+		const double Texels = (Position - SnapOrigin) / TexelSize;
+		return (Texels - std::floor(Texels)) * TexelSize;
+	}
+}
@@ -0,0 +1,71 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#pragma once
+
+// Engine-independent on purpose: nothing in this header or its implementation may include an
+// Unreal header. The module compiles it like any other file, and Tools/GrassKernels builds it
+// natively, so the pixel and placement math can be measured on machines without the engine.
+
+#include <cstdint>
+
+/**
+ * The per-texel math behind grass generation, free of UObjects.
+ *
+ * Weightmaps are handled as BGRA8 texel arrays - four bytes per texel, in the order FColor
+ * stores them on every platform Unreal ships - addressed by a texel stride and a rectangle.
+ * A weight channel is a byte offset into each texel.
+ */
+namespace GrassKernels
+{
+	/** Bytes per weightmap texel. */
+	constexpr int32_t BytesPerTexel = 4;
+
+	/** Half a texel, the offset used to centre the virtual texture snap on the landscape grid. */
+	constexpr double HalfTexel = 0.5;
+
+	/** A rectangle of texels. Max is exclusive. */
+	struct FTexelRect
+	{
+		int32_t MinX = 0;
+		int32_t MinY = 0;
+		int32_t MaxX = 0;
+		int32_t MaxY = 0;
+
+		int32_t Width() const { return MaxX - MinX; }
+		int32_t Height() const { return MaxY - MinY; }
+		int64_t Area() const { return static_cast<int64_t>(Width()) * Height(); }
+	};
+
+	/**
+	 * Maps a weightmap channel index - 0 to 3 for R, G, B, A, as landscape layer allocations
+	 * number them - onto its byte offset within a BGRA8 texel. Returns -1 for anything else.
+	 */
+	int32_t GetChannelOffset(int32_t ChannelIndex);
+
+	/** Sets Count weights to Weight. */
+	void FillWeights(uint8_t Weight, int64_t Count, uint8_t* OutWeights);
+
+	/** Copies one channel of Rect out of Texels into OutChannel, row-major, Rect.Area() bytes. */
+	void CaptureChannel(
+		const uint8_t* Texels, int32_t Stride, const FTexelRect& Rect, int32_t ChannelOffset, uint8_t* OutChannel);
+
+	/**
+	 * Writes Weights into one channel of Rect. Weights is row-major with WeightStride bytes per
+	 * row and starts at Rect's first texel.
+	 */
+	void WriteChannel(
+		uint8_t* Texels, int32_t Stride, const FTexelRect& Rect, int32_t ChannelOffset,
+		const uint8_t* Weights, int32_t WeightStride);
+
+	/**
+	 * Virtual texture texels per landscape vertex: the virtual texture size over the landscape
+	 * size, both rounded to powers of two, and never less than one.
+	 */
+	int32_t GetVirtualTextureTexelsPerVertex(int32_t LandscapeSizeX, int32_t LandscapeSizeY, int32_t VirtualTextureSize);
+
+	/**
+	 * How far Position sits past the nearest texel boundary at or below it, for a grid of
+	 * TexelSize anchored half a texel before Origin. Subtracting it snaps Position to the grid.
+	 */
+	double GetTexelSnapOffset(double Position, double Origin, double TexelSize);
+}
@@ -0,0 +1,301 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#include "GrassNoiseKernels.h"
+
+#include "GrassTerrainKernels.h"
+
+#include <algorithm>
+
+// Every quantity fits 32 bits, so the lane loops compile to 32-bit vector lanes. Right shifts of
+// negative values are arithmetic - floor division by a power of two - as they are on every
+// compiler the engine supports, and as C++20 guarantees.
+
+namespace GrassKernels
+{
+	namespace
+	{
+		/** Lattice positions are 16.16 and wrap at 32 bits, which the period mask never reaches. */
+		constexpr int32_t PositionShift = 16;
+		constexpr uint32_t PositionFractionMask = (1u << PositionShift) - 1;
+
+		/**
+		 * Where vertex 0 sits inside its lattice cell along each axis, 16.16. Gradient noise is zero
+		 * on the lattice itself, and at power-of-two frequencies whole rows and columns of vertices
+		 * would land on it; odd fractions keep every vertex off it.
+		 */
+		constexpr uint32_t SampleOffsetX = 0x9e37u;
+		constexpr uint32_t SampleOffsetY = 0x5a83u;
+
+		/**
+		 * Gradient dot products work on 12-bit fractions, so the differences the interpolation
+		 * multiplies by a 16-bit fade stay inside 31 bits.
+		 */
+		constexpr int32_t OffsetShift = 12;
+		constexpr int32_t OffsetOne = 1 << OffsetShift;
+
+		/** Vertices EvaluateNoiseRow sums all the octaves of before moving on: NoiseLanes several times over. */
+		constexpr int32_t NoiseBlock = 8 * NoiseLanes;
+
+		/** Vertices ModulateWeights evaluates per call into its row buffer. */
+		constexpr int32_t ModulateChunk = 256;
+
+		/** Multipliers decorrelating the lattice axes and octaves before the finaliser. */
+		constexpr uint32_t HashMultiplierX = 0x8da6b343u;
+		constexpr uint32_t HashMultiplierY = 0xd8163841u;
+		constexpr uint32_t HashMultiplierOctave = 0xcb1ab31fu;
+
+		/** Avalanches a 32-bit key so every input bit affects every output bit. */
+		uint32_t FinaliseHash(uint32_t Hash)
+		{
+			Hash ^= Hash >> 15;
+			Hash *= 0x2c1b3c6du;
+			Hash ^= Hash >> 12;
+			Hash *= 0x297a2d39u;
+			Hash ^= Hash >> 15;
+			return Hash;
+		}
+
+		/** Everything about a lattice corner's hash except its X, which varies along a row. */
+		uint32_t MakeRowKey(uint32_t Seed, int32_t Octave, uint32_t CellY)
+		{
+			return Seed ^ (CellY * HashMultiplierY) ^ (static_cast<uint32_t>(Octave) * HashMultiplierOctave);
+		}
+
+		/**
+		 * Dot product of the corner's gradient with the offset (DX, DY) to it, both in OffsetOne
+		 * units. Eight gradients: the four diagonals, and the four axis directions. Bit masks rather
+		 * than a table, a switch or even selects, which keep compilers from vectorising the lanes.
+		 */
+		int32_t DotGradient(uint32_t Hash, int32_t DX, int32_t DY)
+		{
+			// Each hash bit spread to a whole mask by shifting it to the top and back.
+			const int32_t Bit0 = static_cast<int32_t>(Hash << 31) >> 31;
+			const int32_t Bit1 = static_cast<int32_t>(Hash << 30) >> 31;
+			const int32_t Bit2 = static_cast<int32_t>(Hash << 29) >> 31;
+			const int32_t Bit3 = static_cast<int32_t>(Hash << 28) >> 31;
+
+			// Bits 0 and 1 negate the terms; bits 3 and 2 together drop X, bit 3 alone drops Y.
+			const int32_t SignX = Bit0;
+			const int32_t SignY = Bit1;
+			const int32_t KeepX = ~(Bit3 & Bit2);
+			const int32_t KeepY = ~Bit3 | Bit2;
+
+			return (((DX ^ SignX) - SignX) & KeepX) + (((DY ^ SignY) - SignY) & KeepY);
+		}
+
+		/** 6t^5 - 15t^4 + 10t^3, for a position fraction t; 0 to NoiseOne. */
+		int32_t Fade(uint32_t T)
+		{
+			const uint32_t Square = (T * T) >> PositionShift;
+			const uint32_t Cube = (Square * T) >> PositionShift;
+			// 6t^2 - 15t + 10 is at least 1 on [0, 1], so this never goes negative.
+			const uint32_t Inner = 6 * Square - 15 * T + 10 * static_cast<uint32_t>(NoiseOne);
+			// Inner is below 10 * NoiseOne; four bits off it keep the product inside 32 bits.
+			return static_cast<int32_t>((Cube * (Inner >> 4)) >> (PositionShift - 4));
+		}
+
+		int32_t Lerp(int32_t A, int32_t B, int32_t Alpha)
+		{
+			return A + (((B - A) * Alpha) >> PositionShift);
+		}
+
+		uint32_t GetBaseFrequency(const FNoiseSettings& Settings)
+		{
+			return std::min(Settings.Frequency, static_cast<uint32_t>(MaxNoiseFrequency));
+		}
+
+		/**
+		 * The requested octaves, less any whose frequency would reach a cell per vertex: sampled
+		 * once per cell or coarser, they alias into a fixed pattern instead of adding detail, and
+		 * cost a full evaluation each.
+		 */
+		int32_t GetOctaveCount(const FNoiseSettings& Settings)
+		{
+			const uint32_t Frequency = GetBaseFrequency(Settings);
+			int32_t Octaves = std::clamp(Settings.Octaves, 1, MaxNoiseOctaves);
+			while (Octaves > 1 && (Frequency << (Octaves - 1)) >= static_cast<uint32_t>(NoiseOne))
+			{
+				--Octaves;
+			}
+			return Octaves;
+		}
+
+		/** Octave's lattice frequency and the mask that wraps its cells to the period. */
+		void GetOctaveLattice(const FNoiseSettings& Settings, int32_t Octave, uint32_t& OutFrequency, uint32_t& OutPeriodMask)
+		{
+			const int32_t PeriodLog2 = std::clamp(Settings.PeriodLog2, 0, MaxNoisePeriodLog2);
+			OutFrequency = GetBaseFrequency(Settings) << Octave;
+			OutPeriodMask = (1u << (PeriodLog2 + Octave)) - 1;
+		}
+
+		/**
+		 * 1 over the sum of the octaves' amplitudes, 16.16, so the fractal sum spans the same
+		 * range whatever the octave count.
+		 */
+		int32_t GetOctaveNormalisation(int32_t Octaves)
+		{
+			return (1 << (Octaves - 1 + PositionShift)) / ((1 << Octaves) - 1);
+		}
+
+		int16_t ToNoiseValue(int32_t Sum, int32_t Normalisation)
+		{
+			// An octave spans about -OffsetOne to OffsetOne; scaled up to fill int16.
+			const int32_t Value = (Sum * Normalisation) >> (PositionShift + OffsetShift - 15);
+			return static_cast<int16_t>(std::clamp(Value, -NoiseRange, NoiseRange));
+		}
+
+		/** One octave at lattice position U along a row, given the row's precomputed terms. */
+		int32_t EvaluateOctaveAt(
+			uint32_t U, uint32_t PeriodMask, uint32_t RowKey0, uint32_t RowKey1, int32_t OffsetY, int32_t FadeY)
+		{
+			const uint32_t CellX = U >> PositionShift;
+			const int32_t OffsetX = static_cast<int32_t>((U & PositionFractionMask) >> (PositionShift - OffsetShift));
+			const uint32_t ColumnKey0 = (CellX & PeriodMask) * HashMultiplierX;
+			const uint32_t ColumnKey1 = ((CellX + 1) & PeriodMask) * HashMultiplierX;
+
+			const int32_t Corner00 = DotGradient(FinaliseHash(RowKey0 ^ ColumnKey0), OffsetX, OffsetY);
+			const int32_t Corner10 = DotGradient(FinaliseHash(RowKey0 ^ ColumnKey1), OffsetX - OffsetOne, OffsetY);
+			const int32_t Corner01 = DotGradient(FinaliseHash(RowKey1 ^ ColumnKey0), OffsetX, OffsetY - OffsetOne);
+			const int32_t Corner11 = DotGradient(FinaliseHash(RowKey1 ^ ColumnKey1), OffsetX - OffsetOne, OffsetY - OffsetOne);
+
+			const int32_t FadeX = Fade(U & PositionFractionMask);
+			return Lerp(Lerp(Corner00, Corner10, FadeX), Lerp(Corner01, Corner11, FadeX), FadeY);
+		}
+
+		/** Everything about one octave of a row that depends only on Y. */
+		struct FOctaveRow
+		{
+			uint32_t Frequency = 0;
+			uint32_t PeriodMask = 0;
+			uint32_t RowKey0 = 0;
+			uint32_t RowKey1 = 0;
+			int32_t OffsetY = 0;
+			int32_t FadeY = 0;
+		};
+
+		FOctaveRow MakeOctaveRow(const FNoiseSettings& Settings, int32_t Octave, int32_t Y)
+		{
+			FOctaveRow Row;
+			GetOctaveLattice(Settings, Octave, Row.Frequency, Row.PeriodMask);
+
+			const uint32_t V = static_cast<uint32_t>(Y) * Row.Frequency + SampleOffsetY;
+			const uint32_t CellY = V >> PositionShift;
+			Row.OffsetY = static_cast<int32_t>((V & PositionFractionMask) >> (PositionShift - OffsetShift));
+			Row.FadeY = Fade(V & PositionFractionMask);
+			Row.RowKey0 = MakeRowKey(Settings.Seed, Octave, CellY & Row.PeriodMask);
+			Row.RowKey1 = MakeRowKey(Settings.Seed, Octave, (CellY + 1) & Row.PeriodMask);
+			return Row;
+		}
+	}
+
+	int16_t EvaluateNoise(const FNoiseSettings& Settings, int32_t X, int32_t Y)
+	{
+		const int32_t Octaves = GetOctaveCount(Settings);
+
+		int32_t Sum = 0;
+		for (int32_t Octave = 0; Octave < Octaves; ++Octave)
+		{
+			const FOctaveRow Row = MakeOctaveRow(Settings, Octave, Y);
+			const uint32_t U = static_cast<uint32_t>(X) * Row.Frequency + SampleOffsetX;
+			Sum += EvaluateOctaveAt(U, Row.PeriodMask, Row.RowKey0, Row.RowKey1, Row.OffsetY, Row.FadeY) >> Octave;
+		}
+
+		return ToNoiseValue(Sum, GetOctaveNormalisation(Octaves));
+	}
+
+	void EvaluateNoiseRow(const FNoiseSettings& Settings, int32_t X, int32_t Y, int32_t Count, int16_t* OutNoise)
+	{
+		const int32_t Octaves = GetOctaveCount(Settings);
+		const int32_t Normalisation = GetOctaveNormalisation(Octaves);
+
+		FOctaveRow Rows[MaxNoiseOctaves];
+		for (int32_t Octave = 0; Octave < Octaves; ++Octave)
+		{
+			Rows[Octave] = MakeOctaveRow(Settings, Octave, Y);
+		}
+
+		// A block at a time, octave by octave: the lane loop is long and uniform enough for the
+		// compiler to run NoiseLanes vertices per instruction, and the sums stay in cache.
+		for (int32_t Start = 0; Start < Count; Start += NoiseBlock)
+		{
+			const int32_t Lanes = std::min(NoiseBlock, Count - Start);
+			int32_t Sums[NoiseBlock] = {};
+
+			for (int32_t Octave = 0; Octave < Octaves; ++Octave)
+			{
+				const FOctaveRow Row = Rows[Octave];
+				const uint32_t BlockU = static_cast<uint32_t>(X + Start) * Row.Frequency + SampleOffsetX;
+
+				// EvaluateOctaveAt spelled out: left as a call, compilers judge it too big to inline
+				// here and the loop stays scalar.
+				for (int32_t Lane = 0; Lane < Lanes; ++Lane)
+				{
+					// Wrapping arithmetic: the same bits as starting from the lane's own X.
+					const uint32_t U = BlockU + static_cast<uint32_t>(Lane) * Row.Frequency;
+					const uint32_t CellX = U >> PositionShift;
+					const int32_t OffsetX = static_cast<int32_t>((U & PositionFractionMask) >> (PositionShift - OffsetShift));
+					const uint32_t ColumnKey0 = (CellX & Row.PeriodMask) * HashMultiplierX;
+					const uint32_t ColumnKey1 = ((CellX + 1) & Row.PeriodMask) * HashMultiplierX;
+
+					const int32_t Corner00 = DotGradient(FinaliseHash(Row.RowKey0 ^ ColumnKey0), OffsetX, Row.OffsetY);
+					const int32_t Corner10 = DotGradient(FinaliseHash(Row.RowKey0 ^ ColumnKey1), OffsetX - OffsetOne, Row.OffsetY);
+					const int32_t Corner01 = DotGradient(FinaliseHash(Row.RowKey1 ^ ColumnKey0), OffsetX, Row.OffsetY - OffsetOne);
+					const int32_t Corner11 = DotGradient(FinaliseHash(Row.RowKey1 ^ ColumnKey1), OffsetX - OffsetOne, Row.OffsetY - OffsetOne);
+
+					const int32_t FadeX = Fade(U & PositionFractionMask);
+					Sums[Lane] += Lerp(Lerp(Corner00, Corner10, FadeX), Lerp(Corner01, Corner11, FadeX), Row.FadeY) >> Octave;
+				}
+			}
+
+			for (int32_t Lane = 0; Lane < Lanes; ++Lane)
+			{
+				OutNoise[Start + Lane] = ToNoiseValue(Sums[Lane], Normalisation);
+			}
+		}
+	}
+
+	void ModulateWeights(
+		const FNoiseSettings& Settings, int32_t Strength, int32_t BaseX, int32_t BaseY, int32_t SubsectionQuads,
+		int32_t Width, int32_t Height, uint8_t* Weights)
+	{
+		Strength = std::clamp(Strength, 0, NoiseOne);
+
+		if (Width <= 0)
+		{
+			return;
+		}
+
+		int16_t Noise[ModulateChunk];
+		const int32_t LastVertexX = GetWeightmapTexelVertex(Width - 1, SubsectionQuads);
+
+		for (int32_t Y = 0; Y < Height; ++Y)
+		{
+			const int32_t VertexY = BaseY + GetWeightmapTexelVertex(Y, SubsectionQuads);
+
+			// Texels map onto vertices in order, so each chunk of vertices serves a run of texels.
+			int32_t X = 0;
+			while (X < Width)
+			{
+				const int32_t ChunkStart = GetWeightmapTexelVertex(X, SubsectionQuads);
+				const int32_t ChunkVertices = std::min(ModulateChunk, LastVertexX + 1 - ChunkStart);
+				EvaluateNoiseRow(Settings, BaseX + ChunkStart, VertexY, ChunkVertices, Noise);
+
+				for (; X < Width; ++X)
+				{
+					const int32_t Index = GetWeightmapTexelVertex(X, SubsectionQuads) - ChunkStart;
+					if (Index >= ChunkVertices)
+					{
+						break;
+					}
+
+					// Noise mapped to 0..NoiseOne, then the weight scaled towards 1 - Strength as it falls.
+					const int64_t Unit = Noise[Index] + (NoiseOne / 2);
+					const int64_t Scale = NoiseOne - ((Strength * (NoiseOne - Unit)) >> PositionShift);
+					Weights[X] = static_cast<uint8_t>((Weights[X] * Scale + NoiseOne / 2) >> PositionShift);
+				}
+			}
+
+			Weights += Width;
+		}
+	}
+}
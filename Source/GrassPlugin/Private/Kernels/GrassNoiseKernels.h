@@ -0,0 +1,80 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#pragma once
+
+// Engine-independent, like GrassKernels.h: no Unreal headers here or in the implementation.
+
+#include <cstdint>
+
+/**
+ * Seeded, tileable fractal gradient noise over the landscape's vertex grid.
+ *
+ * Integer arithmetic throughout - 16.16 fixed point for positions and a 32-bit integer hash for
+ * the lattice - so a given seed produces the same bits on every compiler, CPU and vector width,
+ * and a vertex two components share gets one value however each side reaches it. The noise
+ * itself needs nothing wider than 32 bits; only ModulateWeights widens, to scale the weights.
+ *
+ * Rows are evaluated in plain loops shaped for the compiler's auto-vectoriser, with no
+ * intrinsics: how many lanes that gives depends on the compiler and the target instruction set,
+ * and a scalar build is still correct, only slower. GrassKernelBenchmark reports the row
+ * evaluation's speed-up over the scalar reference, which is where a lost vectorisation shows.
+ */
+namespace GrassKernels
+{
+	/**
+	 * Granularity of the row evaluation's blocks: eight 32-bit lanes, so a block divides evenly
+	 * into SSE, NEON and AVX2 registers alike. Sets the loop shape only, not the vector width.
+	 */
+	constexpr int32_t NoiseLanes = 8;
+
+	/** Noise values run from -NoiseRange to NoiseRange. */
+	constexpr int32_t NoiseRange = 32767;
+
+	/** Fixed-point one, for NoiseSettings::Frequency and the modulation strength. */
+	constexpr int32_t NoiseOne = 1 << 16;
+
+	/** Highest first-octave frequency: two vertices per lattice cell. */
+	constexpr int32_t MaxNoiseFrequency = NoiseOne / 2;
+
+	constexpr int32_t MaxNoiseOctaves = 8;
+
+	/** Lattice cells are wrapped in 16 bits at the last octave. */
+	constexpr int32_t MaxNoisePeriodLog2 = 16 - (MaxNoiseOctaves - 1);
+
+	struct FNoiseSettings
+	{
+		uint32_t Seed = 0;
+
+		/** Lattice cells per vertex at the first octave, 16.16 fixed point, up to MaxNoiseFrequency. Each octave doubles it. */
+		uint32_t Frequency = NoiseOne / 64;
+
+		/**
+		 * 1 to MaxNoiseOctaves. Each adds detail at half the amplitude of the one before; octaves
+		 * that would reach a lattice cell per vertex are dropped, as they add none.
+		 */
+		int32_t Octaves = 4;
+
+		/**
+		 * The pattern repeats every 1 << PeriodLog2 lattice cells of the first octave along each
+		 * axis, up to MaxNoisePeriodLog2; later octaves repeat at the same distance. At the default
+		 * frequency that is every 32768 vertices.
+		 */
+		int32_t PeriodLog2 = MaxNoisePeriodLog2;
+	};
+
+	/** Noise at vertex (X, Y). The reference the row evaluation must match bit for bit. */
+	int16_t EvaluateNoise(const FNoiseSettings& Settings, int32_t X, int32_t Y);
+
+	/** Noise at vertices (X + I, Y) for I in [0, Count), into OutNoise. */
+	void EvaluateNoiseRow(const FNoiseSettings& Settings, int32_t X, int32_t Y, int32_t Count, int16_t* OutNoise);
+
+	/**
+	 * Scales every weight of a Width x Height weightmap region by the noise at its vertex: by 1
+	 * where the noise is highest, and by down to 1 - Strength where it is lowest. Strength is
+	 * fixed point, 0 to NoiseOne. BaseX and BaseY are the component's section base, so the same
+	 * vertex is scaled the same in every component that holds it.
+	 */
+	void ModulateWeights(
+		const FNoiseSettings& Settings, int32_t Strength, int32_t BaseX, int32_t BaseY, int32_t SubsectionQuads,
+		int32_t Width, int32_t Height, uint8_t* Weights);
+}
@@ -0,0 +1,129 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#include "GrassTerrainKernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace GrassKernels
+{
+	namespace
+	{
+		constexpr float RadiansToDegrees = 57.2957795f;
+		constexpr float MaxSlopeDegrees = 90.0f;
+		constexpr float NormalQuantisation = 127.0f;
+
+		int8_t QuantiseNormal(float Value)
+		{
+			return static_cast<int8_t>(std::lround(std::clamp(Value, -1.0f, 1.0f) * NormalQuantisation));
+		}
+	}
+
+	void DecodeHeights(
+		const uint8_t* Texels, int32_t Stride, const FTexelRect& Rect, uint16_t* OutHeights, int32_t OutStride)
+	{
+		const int32_t Width = Rect.Width();
+		for (int32_t Y = Rect.MinY; Y < Rect.MaxY; ++Y)
+		{
+			const uint8_t* Source = Texels + (static_cast<int64_t>(Y) * Stride + Rect.MinX) * BytesPerTexel;
+			for (int32_t X = 0; X < Width; ++X)
+			{
+				OutHeights[X] = DecodeHeight(Source + X * BytesPerTexel);
+			}
+			OutHeights += OutStride;
+		}
+	}
+
+	uint16_t ExtrapolateBorderHeight(const uint16_t* BorderedHeights, int32_t Vertices, int32_t X, int32_t Y)
+	{
+		const int32_t BorderedStride = Vertices + 2;
+		const auto At = [BorderedHeights, BorderedStride](int32_t SampleX, int32_t SampleY)
+		{
+			return static_cast<int32_t>(BorderedHeights[(SampleY + 1) * BorderedStride + SampleX + 1]);
+		};
+
+		// The nearest tile sample, and the one as far again inside; the border sample continues
+		// the line through them.
+		const int32_t EdgeX = std::clamp(X, 0, Vertices - 1);
+		const int32_t EdgeY = std::clamp(Y, 0, Vertices - 1);
+		const int32_t InnerX = std::clamp(2 * EdgeX - X, 0, Vertices - 1);
+		const int32_t InnerY = std::clamp(2 * EdgeY - Y, 0, Vertices - 1);
+
+		return static_cast<uint16_t>(std::clamp(2 * At(EdgeX, EdgeY) - At(InnerX, InnerY), 0, 0xffff));
+	}
+
+	uint8_t EncodeSlope(float Degrees)
+	{
+		return static_cast<uint8_t>(std::lround(std::clamp(Degrees, 0.0f, MaxSlopeDegrees) * (255.0f / MaxSlopeDegrees)));
+	}
+
+	float DecodeSlope(uint8_t Slope)
+	{
+		return Slope * (MaxSlopeDegrees / 255.0f);
+	}
+
+	void ComputeNormalsAndSlopes(
+		const uint16_t* BorderedHeights, int32_t Vertices, const FTerrainScale& Scale,
+		uint16_t* OutNormals, uint8_t* OutSlopes)
+	{
+		const int32_t BorderedStride = Vertices + 2;
+		const float GradientScaleX = Scale.HeightToWorld / (2.0f * Scale.SpacingX);
+		const float GradientScaleY = Scale.HeightToWorld / (2.0f * Scale.SpacingY);
+
+		for (int32_t Y = 0; Y < Vertices; ++Y)
+		{
+			// Row Y of the tile is row Y + 1 of the bordered heights; Centre points at its sample 0.
+			const uint16_t* Centre = BorderedHeights + (Y + 1) * BorderedStride + 1;
+
+			for (int32_t X = 0; X < Vertices; ++X)
+			{
+				const float SlopeX = (static_cast<float>(Centre[X + 1]) - Centre[X - 1]) * GradientScaleX;
+				const float SlopeY = (static_cast<float>(Centre[X + BorderedStride]) - Centre[X - BorderedStride]) * GradientScaleY;
+
+				// The normal of z = f(x, y) is (-df/dx, -df/dy, 1), normalised.
+				const float Steepness = std::sqrt(SlopeX * SlopeX + SlopeY * SlopeY);
+				const float InverseLength = 1.0f / std::sqrt(1.0f + Steepness * Steepness);
+
+				const uint8_t NormalX = static_cast<uint8_t>(QuantiseNormal(-SlopeX * InverseLength));
+				const uint8_t NormalY = static_cast<uint8_t>(QuantiseNormal(-SlopeY * InverseLength));
+				if (OutNormals)
+				{
+					OutNormals[X] = static_cast<uint16_t>(NormalX | (NormalY << 8));
+				}
+				OutSlopes[X] = EncodeSlope(std::atan(Steepness) * RadiansToDegrees);
+			}
+
+			OutNormals = OutNormals ? OutNormals + Vertices : nullptr;
+			OutSlopes += Vertices;
+		}
+	}
+
+	float UnpackNormalZ(uint16_t PackedNormal)
+	{
+		const float X = static_cast<int8_t>(PackedNormal & 0xff) / NormalQuantisation;
+		const float Y = static_cast<int8_t>(PackedNormal >> 8) / NormalQuantisation;
+		return std::sqrt(std::max(0.0f, 1.0f - X * X - Y * Y));
+	}
+
+	void ApplySlopeLimit(
+		const uint8_t* Slopes, int32_t Vertices, int32_t SubsectionQuads, uint8_t MaxSlope,
+		int32_t Width, int32_t Height, uint8_t* Weights)
+	{
+		for (int32_t Y = 0; Y < Height; ++Y)
+		{
+			const int32_t VertexY = std::min(GetWeightmapTexelVertex(Y, SubsectionQuads), Vertices - 1);
+			const uint8_t* SlopeRow = Slopes + static_cast<int64_t>(VertexY) * Vertices;
+
+			for (int32_t X = 0; X < Width; ++X)
+			{
+				const int32_t VertexX = std::min(GetWeightmapTexelVertex(X, SubsectionQuads), Vertices - 1);
+				if (SlopeRow[VertexX] > MaxSlope)
+				{
+					Weights[X] = 0;
+				}
+			}
+
+			Weights += Width;
+		}
+	}
+}
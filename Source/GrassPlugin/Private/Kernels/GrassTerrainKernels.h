@@ -0,0 +1,81 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+#pragma once
+
+// Engine-independent, like GrassKernels.h: no Unreal headers here or in the implementation.
+
+#include "GrassKernels.h"
+
+/**
+ * Heightmap decoding and the terrain quantities derived from it.
+ *
+ * A component's terrain is held as a tile of Vertices x Vertices samples. Heights carry a
+ * one-vertex border copied from the neighbouring components, so a central difference at the
+ * tile's edge reads the same values it would in the middle of the landscape and never has to
+ * find the neighbour itself.
+ */
+namespace GrassKernels
+{
+	/** A heightmap texel holds a 16-bit height, high byte in red and low byte in green. */
+	inline uint16_t DecodeHeight(const uint8_t* Texel)
+	{
+		// BGRA8: red is byte 2, green byte 1.
+		return static_cast<uint16_t>((Texel[2] << 8) | Texel[1]);
+	}
+
+	/** Decodes the heights of Rect into OutHeights, OutStride entries per row. */
+	void DecodeHeights(
+		const uint8_t* Texels, int32_t Stride, const FTexelRect& Rect, uint16_t* OutHeights, int32_t OutStride);
+
+	/**
+	 * Height for border sample (X, Y) of a bordered tile when there is no neighbour to copy it
+	 * from: extended linearly from the two tile samples nearest it, so the edge keeps the slope it
+	 * has rather than reading as flat. X and Y run from -1 to Vertices.
+	 */
+	uint16_t ExtrapolateBorderHeight(const uint16_t* BorderedHeights, int32_t Vertices, int32_t X, int32_t Y);
+
+	/** World size of one height step and of the gap between vertices. */
+	struct FTerrainScale
+	{
+		float HeightToWorld = 1.0f;
+		float SpacingX = 1.0f;
+		float SpacingY = 1.0f;
+	};
+
+	/** Slopes are stored as a byte: 0 is flat and 255 vertical, in even steps of angle. */
+	uint8_t EncodeSlope(float Degrees);
+	float DecodeSlope(uint8_t Slope);
+
+	/**
+	 * Unit normal and slope of every vertex of a tile, by central differences over
+	 * BorderedHeights, (Vertices + 2) squared.
+	 *
+	 * OutNormals holds the normal's X and Y as signed 8-bit values, X in the low byte. Z is
+	 * never negative on a heightfield, so it is left out; UnpackNormalZ rebuilds it.
+	 * OutSlopes is in EncodeSlope units. Both are Vertices squared, row-major. OutNormals may be
+	 * null when only the slopes are wanted.
+	 */
+	void ComputeNormalsAndSlopes(
+		const uint16_t* BorderedHeights, int32_t Vertices, const FTerrainScale& Scale,
+		uint16_t* OutNormals, uint8_t* OutSlopes);
+
+	/** The Z component of a unit normal packed by ComputeNormalsAndSlopes. */
+	float UnpackNormalZ(uint16_t PackedNormal);
+
+	/**
+	 * The vertex a weightmap texel sits on, along one axis. Weightmaps give each subsection its
+	 * own SubsectionQuads + 1 texels, so the vertex two subsections share appears twice.
+	 */
+	inline int32_t GetWeightmapTexelVertex(int32_t Texel, int32_t SubsectionQuads)
+	{
+		return (Texel / (SubsectionQuads + 1)) * SubsectionQuads + Texel % (SubsectionQuads + 1);
+	}
+
+	/**
+	 * Zeroes every weight of a Width x Height weightmap region whose vertex is steeper than
+	 * MaxSlope. Slopes is the component's Vertices-square tile from ComputeNormalsAndSlopes.
+	 */
+	void ApplySlopeLimit(
+		const uint8_t* Slopes, int32_t Vertices, int32_t SubsectionQuads, uint8_t MaxSlope,
+		int32_t Width, int32_t Height, uint8_t* Weights);
+}
@@ -12,6 +12,7 @@ class ULandscapeLayerInfoObject;
 class UMaterialInterface;
 class UPhysicalMaterial;
 class URuntimeVirtualTexture;
+struct FGrassGenerationPlan;
 
 /**
  * Editor utility actor that prepares a landscape for the stylized grass setup: it assigns the
@@ -36,6 +37,14 @@ public:
 	UFUNCTION(CallInEditor, Category = "Grass Generation")
 	void GenerateGrass();
 
+	/**
+	 * Logs what GenerateGrass would do - materials to assign, assets to create and save,
+	 * components to allocate, weightmaps and bytes to write, and a time estimate - without
+	 * changing anything.
+	 */
+	UFUNCTION(CallInEditor, Category = "Grass Generation")
+	void PlanGrassGeneration();
+
 	//~ Begin AActor interface
 	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 	virtual void Destroyed() override;
@@ -74,6 +83,67 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grass Generation|Layers")
 	FString LayerInfoPackageRoot;
 
+	// -- Rules -------------------------------------------------------------------------
+
+	/**
+	 * Steepest terrain the grass layer is painted on. Vertices steeper than this are left at
+	 * zero grass weight. 90 paints everywhere.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grass Generation|Rules",
+		meta = (ClampMin = "0.0", ClampMax = "90.0", Units = "Degrees"))
+	float MaxGrassSlope;
+
+	/**
+	 * How strongly noise breaks up the grass layer into patches. At 1 the grass weight falls to
+	 * zero where the noise is lowest; 0 paints it evenly. The pattern is fixed by the seed and
+	 * continues across components and landscapes sharing a coordinate space.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grass Generation|Rules",
+		meta = (ClampMin = "0.0", ClampMax = "1.0"))
+	float GrassNoiseStrength;
+
+	/** Picks the noise pattern. The same seed gives the same patches on every machine. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grass Generation|Rules")
+	int32 GrassNoiseSeed;
+
+	/** Size of the largest patches, in landscape vertices. At least two: a vertex cannot vary within itself. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grass Generation|Rules",
+		meta = (ClampMin = "2.0", ClampMax = "4096.0"))
+	float GrassNoiseScale;
+
+	/**
+	 * Layers of finer detail over the largest patches, each half the size of the one before.
+	 * Layers that would come out smaller than two vertices are left out.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grass Generation|Rules",
+		meta = (ClampMin = "1", ClampMax = "8"))
+	int32 GrassNoiseOctaves;
+
+	// -- Cache -------------------------------------------------------------------------
+
+	/**
+	 * Reuses grass weight tiles computed by earlier runs instead of recomputing them. Tiles are
+	 * keyed by the weight rules and, when the slope limit is on, the component's heightmap, so
+	 * any change to either simply misses. Only used when the slope limit or noise is on: without
+	 * them the weights are a single value, cheaper to fill than to read back.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grass Generation|Cache")
+	bool bUseWeightCache;
+
+	/**
+	 * Where cached weight tiles are kept. Empty means Saved/GrassPlugin/WeightCache under the
+	 * project. Point several workstations or build machines at one shared folder and each
+	 * reuses the tiles the others computed.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grass Generation|Cache",
+		meta = (EditCondition = "bUseWeightCache"))
+	FDirectoryPath WeightCacheDirectory;
+
+	/** Size the cache is trimmed back to after each run, least recently used tiles first. 0 disables trimming. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Grass Generation|Cache",
+		meta = (EditCondition = "bUseWeightCache", ClampMin = "0", Units = "MB"))
+	int32 WeightCacheSizeLimit;
+
 	// -- Behaviour ---------------------------------------------------------------------
 
 	/**
@@ -108,17 +178,33 @@ private:
 	/** Resolves the soft asset references into the transient hard references. */
 	bool ResolveAssets();
 
-	/** Assigns LandscapeMaterial to every landscape and schedules the deferred passes. */
-	void ApplyLandscapeMaterials();
+	/**
+	 * Works out everything a run would do, reading only. The result drives the passes below,
+	 * which act on it rather than walking the level again.
+	 */
+	void BuildGenerationPlan(FGrassGenerationPlan& OutPlan) const;
+
+	/** Assigns LandscapeMaterial to every landscape the plan marks for it. */
+	void ApplyLandscapeMaterials(const FGrassGenerationPlan& Plan);
+
+	/** Creates and assigns the layer infos, then schedules one weightmap fill for every landscape. */
+	void SetupLayerInfos(const TSharedRef<FGrassGenerationPlan>& Plan);
 
-	/** Creates and assigns the layer infos, then schedules the weightmap fill. */
-	void SetupLayerInfos();
+	/** Creates a runtime virtual texture volume aligned and snapped to each planned landscape. */
+	void SetupVirtualTextureVolume(const FGrassGenerationPlan& Plan);
+
+	/**
+	 * Writes the grass weights into the grass layer's weightmap channel on every planned
+	 * landscape, reusing cached weight tiles where the inputs match. Landscapes are filled
+	 * concurrently; texture locking and updates stay on the game thread.
+	 */
+	void FillGrassLayers(FGrassGenerationPlan& Plan);
 
-	/** Creates a runtime virtual texture volume aligned and snapped to the landscape. */
-	void SetupVirtualTextureVolume();
+	/** Long package name of the layer info asset for LayerName. */
+	FString GetLayerInfoPackageName(FName LayerName) const;
 
-	/** Writes full weight into the grass layer's weightmap channel. */
-	void FillGrassLayer(ALandscape* Landscape, ULandscapeLayerInfoObject* GrassLayerInfo);
+	/** WeightCacheDirectory as an absolute path, or the default under Saved when it is empty. */
+	FString GetWeightCacheDirectory() const;
 
 	/** Loads the layer info asset for LayerName, creating and saving it if absent. */
 	ULandscapeLayerInfoObject* GetOrCreateLayerInfo(FName LayerName, UPhysicalMaterial* PhysMaterial);
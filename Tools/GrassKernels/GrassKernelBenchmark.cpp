@@ -0,0 +1,427 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+// Benchmarks the grass kernels over synthetic landscapes of 1 to 65536 components, through the
+// engine's per-component path with the slope limit and noise on: the terrain build, the fill
+// and undo. Reports throughput per pass and the heap allocations across all of them, and times
+// the noise on one core. Correctness is GrassKernelTests' job. Runs without the engine; see
+// CMakeLists.txt.
+//
+//   GrassKernelBenchmark [--max-components N]
+
+#include "GrassKernels.h"
+#include "GrassNoiseKernels.h"
+#include "GrassTerrainKernels.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+namespace
+{
+	std::atomic<uint64_t> AllocationCount{0};
+	std::atomic<uint64_t> AllocatedBytes{0};
+}
+
+// Counts every heap allocation in the process. The timed passes must not make any: the engine
+// calls the same kernels per component, thousands of times per run.
+void* operator new(std::size_t Size)
+{
+	++AllocationCount;
+	AllocatedBytes += Size;
+	if (void* Memory = std::malloc(Size ? Size : 1))
+	{
+		return Memory;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* Memory) noexcept
+{
+	std::free(Memory);
+}
+
+void operator delete(void* Memory, std::size_t) noexcept
+{
+	std::free(Memory);
+}
+
+namespace
+{
+	using FClock = std::chrono::steady_clock;
+
+	/** Texels along one edge of a component's weightmap: 63 quads in one subsection, plus one. */
+	constexpr int32_t ComponentTexels = 64;
+	constexpr int32_t SubsectionQuads = ComponentTexels - 1;
+
+	/** Samples along one edge of a component's heights, the same as its weightmap here. */
+	constexpr int32_t ComponentVertices = ComponentTexels;
+	constexpr int32_t BorderedVertices = ComponentVertices + 2;
+
+	/**
+	 * Distinct weightmaps, heightmaps and terrain tiles the components use. A 64k-component
+	 * landscape at one of each is several gigabytes; cycling through a fixed set keeps the
+	 * benchmark runnable on a CI machine while still streaming far more than fits in cache. A
+	 * multiple of four, so each weightmap always receives the same channel.
+	 */
+	constexpr int32_t WeightmapPoolSize = 256;
+
+	/** What the weightmaps start out holding. */
+	constexpr uint8_t BackgroundByte = 0x5a;
+
+	/** Texels each configuration processes at least, across repetitions, to get a stable time. */
+	constexpr int64_t MinTexelsPerConfiguration = int64_t(1) << 24;
+
+	/** Rolling hills, in raw height units: steep enough in places for the slope limit to bite. */
+	constexpr float HillHeight = 3000.0f;
+	constexpr float HillFrequency = 0.05f;
+
+	struct FComponent
+	{
+		int32_t PoolIndex;
+		int32_t ChannelOffset;
+		int32_t SectionBaseX;
+		int32_t SectionBaseY;
+	};
+
+	/** One component's decoded terrain, as the engine's terrain cache holds it. */
+	struct FTerrainTile
+	{
+		std::vector<uint16_t> Heights;
+		std::vector<uint16_t> Normals;
+		std::vector<uint8_t> Slopes;
+	};
+
+	/** The rules the engine's fill evaluates, all on: a slope limit and noise. */
+	struct FRules
+	{
+		uint8_t MaxSlope = 0;
+		int32_t NoiseStrength = 0;
+		GrassKernels::FNoiseSettings Noise;
+		GrassKernels::FTerrainScale Scale;
+	};
+
+	struct FScratch
+	{
+		std::vector<uint8_t> Weights;
+		std::vector<uint8_t> Before;
+		std::vector<uint8_t> After;
+	};
+
+	/** Every component's channel before and after the last fill, as its undo record holds them. */
+	struct FUndoRecords
+	{
+		std::vector<uint8_t> Before;
+		std::vector<uint8_t> After;
+	};
+
+	double SecondsSince(FClock::time_point Start)
+	{
+		return std::chrono::duration<double>(FClock::now() - Start).count();
+	}
+
+	FRules MakeRules()
+	{
+		FRules Rules;
+		Rules.MaxSlope = GrassKernels::EncodeSlope(30.0f);
+		Rules.NoiseStrength = GrassKernels::NoiseOne / 2;
+		// The engine's default landscape: 100 units between vertices, heights at 100 / 128.
+		Rules.Scale.HeightToWorld = 100.0f / 128.0f;
+		Rules.Scale.SpacingX = 100.0f;
+		Rules.Scale.SpacingY = 100.0f;
+		return Rules;
+	}
+
+	/** A heightmap for the component at (BaseX, BaseY), encoded as the engine stores it. */
+	std::vector<uint8_t> MakeHeightmap(int32_t BaseX, int32_t BaseY)
+	{
+		std::vector<uint8_t> Texels(size_t(ComponentVertices) * ComponentVertices * GrassKernels::BytesPerTexel);
+		for (int32_t Y = 0; Y < ComponentVertices; ++Y)
+		{
+			for (int32_t X = 0; X < ComponentVertices; ++X)
+			{
+				const float Height = 32768.0f + HillHeight
+					* std::sin((BaseX + X) * HillFrequency) * std::cos((BaseY + Y) * HillFrequency);
+				const uint16_t Encoded = static_cast<uint16_t>(Height);
+
+				// BGRA: height in red and green, high byte first.
+				uint8_t* const Texel = &Texels[(size_t(Y) * ComponentVertices + X) * GrassKernels::BytesPerTexel];
+				Texel[2] = static_cast<uint8_t>(Encoded >> 8);
+				Texel[1] = static_cast<uint8_t>(Encoded & 0xff);
+			}
+		}
+		return Texels;
+	}
+
+	/**
+	 * The engine's terrain build on a cache miss: decode the heights, fill the border, derive
+	 * normals and slopes. Borders are extrapolated, as at the landscape's edge, rather than read
+	 * from neighbours; the cost is the same.
+	 */
+	void TerrainPass(const std::vector<std::vector<uint8_t>>& Heightmaps, const std::vector<FComponent>& Components,
+		const FRules& Rules, std::vector<FTerrainTile>& Tiles)
+	{
+		const GrassKernels::FTexelRect Rect{ 0, 0, ComponentVertices, ComponentVertices };
+
+		for (const FComponent& Component : Components)
+		{
+			FTerrainTile& Tile = Tiles[Component.PoolIndex];
+			uint16_t* const Heights = Tile.Heights.data();
+
+			GrassKernels::DecodeHeights(Heightmaps[Component.PoolIndex].data(), ComponentVertices, Rect,
+				Heights + BorderedVertices + 1, BorderedVertices);
+
+			for (int32_t I = -1; I <= ComponentVertices; ++I)
+			{
+				for (const int32_t Edge : { -1, ComponentVertices })
+				{
+					Heights[(Edge + 1) * BorderedVertices + I + 1] =
+						GrassKernels::ExtrapolateBorderHeight(Heights, ComponentVertices, I, Edge);
+					Heights[(I + 1) * BorderedVertices + Edge + 1] =
+						GrassKernels::ExtrapolateBorderHeight(Heights, ComponentVertices, Edge, I);
+				}
+			}
+
+			GrassKernels::ComputeNormalsAndSlopes(
+				Heights, ComponentVertices, Rules.Scale, Tile.Normals.data(), Tile.Slopes.data());
+		}
+	}
+
+	/**
+	 * The engine's fill, minus compression and I/O: evaluate the rules, capture, write, capture
+	 * again. With Records, each component's captures go into its own undo record.
+	 */
+	void FillPass(std::vector<std::vector<uint8_t>>& Weightmaps, const std::vector<FComponent>& Components,
+		const std::vector<FTerrainTile>& Tiles, const FRules& Rules, uint8_t Weight, FScratch& Scratch,
+		FUndoRecords* Records)
+	{
+		const GrassKernels::FTexelRect Rect{ 0, 0, ComponentTexels, ComponentTexels };
+		const int32_t Area = Rect.Area();
+
+		for (size_t Index = 0; Index < Components.size(); ++Index)
+		{
+			const FComponent& Component = Components[Index];
+			uint8_t* Texels = Weightmaps[Component.PoolIndex].data();
+			uint8_t* const Before = Records ? Records->Before.data() + Index * Area : Scratch.Before.data();
+			uint8_t* const After = Records ? Records->After.data() + Index * Area : Scratch.After.data();
+
+			GrassKernels::FillWeights(Weight, Area, Scratch.Weights.data());
+			GrassKernels::ApplySlopeLimit(Tiles[Component.PoolIndex].Slopes.data(), ComponentVertices, SubsectionQuads,
+				Rules.MaxSlope, ComponentTexels, ComponentTexels, Scratch.Weights.data());
+			GrassKernels::ModulateWeights(Rules.Noise, Rules.NoiseStrength, Component.SectionBaseX, Component.SectionBaseY,
+				SubsectionQuads, ComponentTexels, ComponentTexels, Scratch.Weights.data());
+
+			GrassKernels::CaptureChannel(Texels, ComponentTexels, Rect, Component.ChannelOffset, Before);
+			GrassKernels::WriteChannel(Texels, ComponentTexels, Rect, Component.ChannelOffset, Scratch.Weights.data(), ComponentTexels);
+			GrassKernels::CaptureChannel(Texels, ComponentTexels, Rect, Component.ChannelOffset, After);
+		}
+	}
+
+	/** Writes every component's own recorded channel back, as undo (Channels = Before) or redo would. */
+	void UndoPass(std::vector<std::vector<uint8_t>>& Weightmaps, const std::vector<FComponent>& Components,
+		const std::vector<uint8_t>& Channels)
+	{
+		const GrassKernels::FTexelRect Rect{ 0, 0, ComponentTexels, ComponentTexels };
+		const int32_t Area = Rect.Area();
+
+		for (size_t Index = 0; Index < Components.size(); ++Index)
+		{
+			const FComponent& Component = Components[Index];
+			GrassKernels::WriteChannel(Weightmaps[Component.PoolIndex].data(), ComponentTexels, Rect,
+				Component.ChannelOffset, Channels.data() + Index * Area, ComponentTexels);
+		}
+	}
+
+	/**
+	 * Single-thread noise throughput, in texels per second, at the default octave count: through
+	 * the row evaluation, or vertex by vertex through the scalar reference when bScalar is set.
+	 */
+	double MeasureNoiseTexelsPerSecond(bool bScalar)
+	{
+		constexpr int32_t Size = 1024;
+		constexpr int32_t Runs = 5;
+
+		const GrassKernels::FNoiseSettings Settings;
+		std::vector<int16_t> Row(Size);
+
+		double BestSeconds = 1e30;
+		int64_t Guard = 0;
+		for (int32_t Run = 0; Run < Runs; ++Run)
+		{
+			const FClock::time_point Start = FClock::now();
+			for (int32_t Y = 0; Y < Size; ++Y)
+			{
+				if (bScalar)
+				{
+					for (int32_t X = 0; X < Size; ++X)
+					{
+						Row[X] = GrassKernels::EvaluateNoise(Settings, X, Y);
+					}
+				}
+				else
+				{
+					GrassKernels::EvaluateNoiseRow(Settings, 0, Y, Size, Row.data());
+				}
+				Guard += Row[Y];
+			}
+			BestSeconds = std::min(BestSeconds, SecondsSince(Start));
+		}
+
+		// Keeps the loop from being optimised away.
+		if (Guard == INT64_MIN)
+		{
+			std::printf("%lld\n", static_cast<long long>(Guard));
+		}
+
+		return double(Size) * Size / BestSeconds;
+	}
+
+	struct FResult
+	{
+		double TerrainSeconds = 0.0;
+		double FillSeconds = 0.0;
+		double UndoSeconds = 0.0;
+		uint64_t Allocations = 0;
+	};
+
+	FResult RunConfiguration(int32_t ComponentCount)
+	{
+		const int64_t TexelsPerComponent = int64_t(ComponentTexels) * ComponentTexels;
+		const int32_t PoolSize = std::min(ComponentCount, WeightmapPoolSize);
+		const FRules Rules = MakeRules();
+
+		// Laid out on a square grid, so the noise sees real section bases.
+		int32_t GridSide = 1;
+		while (GridSide * GridSide < ComponentCount)
+		{
+			++GridSide;
+		}
+
+		std::vector<FComponent> Components(ComponentCount);
+		for (int32_t Index = 0; Index < ComponentCount; ++Index)
+		{
+			Components[Index].PoolIndex = Index % PoolSize;
+			Components[Index].ChannelOffset = GrassKernels::GetChannelOffset((Index % PoolSize) % 4);
+			Components[Index].SectionBaseX = (Index % GridSide) * SubsectionQuads;
+			Components[Index].SectionBaseY = (Index / GridSide) * SubsectionQuads;
+		}
+
+		std::vector<std::vector<uint8_t>> Weightmaps(PoolSize,
+			std::vector<uint8_t>(TexelsPerComponent * GrassKernels::BytesPerTexel, BackgroundByte));
+
+		std::vector<std::vector<uint8_t>> Heightmaps;
+		std::vector<FTerrainTile> Tiles(PoolSize);
+		for (int32_t Index = 0; Index < PoolSize; ++Index)
+		{
+			Heightmaps.push_back(MakeHeightmap(Components[Index].SectionBaseX, Components[Index].SectionBaseY));
+			Tiles[Index].Heights.resize(BorderedVertices * BorderedVertices);
+			Tiles[Index].Normals.resize(ComponentVertices * ComponentVertices);
+			Tiles[Index].Slopes.resize(ComponentVertices * ComponentVertices);
+		}
+
+		// Sized once from the component resolution, as the engine's scratch is; the timed passes
+		// must not grow them.
+		FScratch Scratch;
+		Scratch.Weights.resize(TexelsPerComponent);
+		Scratch.Before.resize(TexelsPerComponent);
+		Scratch.After.resize(TexelsPerComponent);
+
+		// Undo is only measured when each weightmap holds exactly one component: then every
+		// component's record is still what its weightmap held, as undo would find it.
+		const bool bMeasureUndo = ComponentCount <= WeightmapPoolSize;
+		FUndoRecords Records;
+		if (bMeasureUndo)
+		{
+			Records.Before.resize(TexelsPerComponent * ComponentCount);
+			Records.After.resize(TexelsPerComponent * ComponentCount);
+		}
+
+		const int64_t Repetitions = std::max<int64_t>(1, MinTexelsPerConfiguration / (TexelsPerComponent * ComponentCount));
+
+		FResult Result;
+		Result.TerrainSeconds = 1e30;
+		Result.FillSeconds = 1e30;
+		Result.UndoSeconds = 1e30;
+
+		const uint64_t AllocationsBefore = AllocationCount.load();
+
+		for (int64_t Repetition = 0; Repetition < Repetitions; ++Repetition)
+		{
+			// Alternating weights, so every pass changes most texels and records a tile.
+			const uint8_t Weight = (Repetition % 2 == 0) ? 0xff : 0xa0;
+
+			const FClock::time_point TerrainStart = FClock::now();
+			TerrainPass(Heightmaps, Components, Rules, Tiles);
+			Result.TerrainSeconds = std::min(Result.TerrainSeconds, SecondsSince(TerrainStart));
+
+			const FClock::time_point FillStart = FClock::now();
+			FillPass(Weightmaps, Components, Tiles, Rules, Weight, Scratch, bMeasureUndo ? &Records : nullptr);
+			Result.FillSeconds = std::min(Result.FillSeconds, SecondsSince(FillStart));
+
+			if (bMeasureUndo)
+			{
+				const FClock::time_point UndoStart = FClock::now();
+				UndoPass(Weightmaps, Components, Records.Before);
+				Result.UndoSeconds = std::min(Result.UndoSeconds, SecondsSince(UndoStart));
+
+				// Redo, so the next repetition starts from this one's result.
+				UndoPass(Weightmaps, Components, Records.After);
+			}
+		}
+
+		Result.Allocations = AllocationCount.load() - AllocationsBefore;
+		return Result;
+	}
+}
+
+int main(int ArgCount, char** Args)
+{
+	int32_t MaxComponents = 65536;
+	for (int ArgIndex = 1; ArgIndex + 1 < ArgCount; ++ArgIndex)
+	{
+		if (std::strcmp(Args[ArgIndex], "--max-components") == 0)
+		{
+			MaxComponents = std::max(1, std::atoi(Args[ArgIndex + 1]));
+		}
+	}
+
+	// The row evaluation relies on the compiler vectorising it. Hoisting the per-row work alone
+	// gives it about 1.3x over the scalar reference; a speed-up that falls to that means it did not.
+	const double NoiseRowTexelsPerSecond = MeasureNoiseTexelsPerSecond(false);
+	const double NoiseScalarTexelsPerSecond = MeasureNoiseTexelsPerSecond(true);
+	std::printf("noise: %.1f Mtexel/s per core at %d octaves, %.1fx the scalar reference (%.1f Mtexel/s)\n",
+		NoiseRowTexelsPerSecond / 1e6, GrassKernels::FNoiseSettings().Octaves,
+		NoiseRowTexelsPerSecond / NoiseScalarTexelsPerSecond, NoiseScalarTexelsPerSecond / 1e6);
+
+	std::printf("%10s %12s %10s %10s %10s %10s %10s %10s %8s\n",
+		"components", "texels", "terrain ms", "Mtexel/s", "fill ms", "Mtexel/s", "undo ms", "Mtexel/s", "allocs");
+
+	for (int32_t ComponentCount = 1; ComponentCount <= MaxComponents; ComponentCount *= 4)
+	{
+		const FResult Result = RunConfiguration(ComponentCount);
+		const double Texels = double(ComponentCount) * ComponentTexels * ComponentTexels;
+		const bool bHasUndo = Result.UndoSeconds < 1e29;
+
+		std::printf("%10d %12.0f %10.3f %10.1f %10.3f %10.1f ", ComponentCount, Texels,
+			Result.TerrainSeconds * 1e3, Texels / Result.TerrainSeconds / 1e6,
+			Result.FillSeconds * 1e3, Texels / Result.FillSeconds / 1e6);
+
+		if (bHasUndo)
+		{
+			std::printf("%10.3f %10.1f ", Result.UndoSeconds * 1e3, Texels / Result.UndoSeconds / 1e6);
+		}
+		else
+		{
+			std::printf("%10s %10s ", "-", "-");
+		}
+
+		std::printf("%8llu\n", static_cast<unsigned long long>(Result.Allocations));
+	}
+
+	return 0;
+}
@@ -0,0 +1,335 @@
+// Copyright (c) Victor Rivas Perez. All Rights Reserved.
+
+// Correctness tests for the grass kernels, against values worked out by hand and, for the
+// noise, a checksum recorded once. Runs without the engine; see CMakeLists.txt, which registers
+// each test with CTest.
+//
+//   GrassKernelTests [test name]
+
+#include "GrassKernels.h"
+#include "GrassNoiseKernels.h"
+#include "GrassTerrainKernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	int32_t FailureCount = 0;
+
+	/** Every check goes through here: reports What and counts the failure when bCondition is false. */
+	void Expect(bool bCondition, const char* What)
+	{
+		if (!bCondition)
+		{
+			std::printf("FAILED: %s\n", What);
+			++FailureCount;
+		}
+	}
+
+	/** Channel mapping and the virtual texture math, against values worked out by hand. */
+	void TestPlacementMath()
+	{
+		Expect(GrassKernels::GetChannelOffset(0) == 2 && GrassKernels::GetChannelOffset(1) == 1
+			&& GrassKernels::GetChannelOffset(2) == 0 && GrassKernels::GetChannelOffset(3) == 3,
+			"channels map onto BGRA8 offsets");
+		Expect(GrassKernels::GetChannelOffset(4) == -1 && GrassKernels::GetChannelOffset(-1) == -1,
+			"out-of-range channels are rejected");
+
+		// A 505-vertex landscape rounds up to 512; a 4096 virtual texture then gives 8 texels per vertex.
+		Expect(GrassKernels::GetVirtualTextureTexelsPerVertex(505, 505, 4096) == 8, "texels per vertex, square");
+		Expect(GrassKernels::GetVirtualTextureTexelsPerVertex(1009, 505, 4096) == 4, "texels per vertex, larger axis wins");
+		Expect(GrassKernels::GetVirtualTextureTexelsPerVertex(8129, 8129, 4096) == 1, "texels per vertex, never below one");
+
+		// Grid of 2-unit texels anchored at -1 (half a texel before 0): 5.5 sits 0.5 past 5.
+		Expect(std::abs(GrassKernels::GetTexelSnapOffset(5.5, 0.0, 2.0) - 0.5) < 1e-9, "snap offset");
+		Expect(std::abs(GrassKernels::GetTexelSnapOffset(-3.0, 0.0, 2.0)) < 1e-9, "snap offset on the grid");
+	}
+
+	/**
+	 * Capture and write on one channel of an offset rect: the rest of the weightmap left alone,
+	 * and writing the capture back restoring it, as undo does.
+	 */
+	void TestChannels()
+	{
+		constexpr int32_t Size = 16;
+		constexpr uint8_t Background = 0x5a;
+		const GrassKernels::FTexelRect Rect{ 3, 5, 11, 12 };
+		const int32_t ChannelOffset = GrassKernels::GetChannelOffset(0);
+
+		std::vector<uint8_t> Texels(Size * Size * GrassKernels::BytesPerTexel);
+		for (size_t Byte = 0; Byte < Texels.size(); ++Byte)
+		{
+			Texels[Byte] = static_cast<uint8_t>(Background + Byte % 7);
+		}
+		const std::vector<uint8_t> Original = Texels;
+
+		std::vector<uint8_t> Before(Rect.Area());
+		std::vector<uint8_t> Weights(Rect.Area());
+		GrassKernels::FillWeights(255, Rect.Area(), Weights.data());
+		GrassKernels::CaptureChannel(Texels.data(), Size, Rect, ChannelOffset, Before.data());
+		GrassKernels::WriteChannel(Texels.data(), Size, Rect, ChannelOffset, Weights.data(), Rect.Width());
+
+		bool bWrittenInside = true;
+		bool bUntouchedOutside = true;
+		for (int32_t Y = 0; Y < Size; ++Y)
+		{
+			for (int32_t X = 0; X < Size; ++X)
+			{
+				for (int32_t Channel = 0; Channel < GrassKernels::BytesPerTexel; ++Channel)
+				{
+					const size_t Byte = (size_t(Y) * Size + X) * GrassKernels::BytesPerTexel + Channel;
+					const bool bInside = X >= Rect.MinX && X < Rect.MaxX && Y >= Rect.MinY && Y < Rect.MaxY;
+					if (bInside && Channel == ChannelOffset)
+					{
+						bWrittenInside &= Texels[Byte] == 255;
+					}
+					else
+					{
+						bUntouchedOutside &= Texels[Byte] == Original[Byte];
+					}
+				}
+			}
+		}
+		Expect(bWrittenInside, "the channel is written across the rect");
+		Expect(bUntouchedOutside, "other channels and texels are left alone");
+
+		GrassKernels::WriteChannel(Texels.data(), Size, Rect, ChannelOffset, Before.data(), Rect.Width());
+		Expect(Texels == Original, "writing the captured channel back restores the weightmap");
+	}
+
+	/** Height decoding, the terrain derivatives and the slope rule, on terrain worked out by hand. */
+	void TestTerrainMath()
+	{
+		const uint8_t Texel[GrassKernels::BytesPerTexel] = { 0x00, 0x34, 0x12, 0xff };
+		Expect(GrassKernels::DecodeHeight(Texel) == 0x1234, "height is red then green");
+
+		// A ramp rising one height step per vertex along X, at unit spacing: 45 degrees, normal
+		// leaning back along -X, and flat along Y.
+		constexpr int32_t Vertices = 8;
+		constexpr int32_t Bordered = Vertices + 2;
+		uint16_t Heights[Bordered * Bordered];
+		for (int32_t Y = 0; Y < Vertices; ++Y)
+		{
+			for (int32_t X = 0; X < Vertices; ++X)
+			{
+				Heights[(Y + 1) * Bordered + X + 1] = static_cast<uint16_t>(1000 + X);
+			}
+		}
+
+		// No neighbours: the whole border is extrapolated, and must continue the ramp.
+		for (int32_t I = -1; I <= Vertices; ++I)
+		{
+			for (const int32_t Edge : { -1, Vertices })
+			{
+				Heights[(Edge + 1) * Bordered + I + 1] = GrassKernels::ExtrapolateBorderHeight(Heights, Vertices, I, Edge);
+				Heights[(I + 1) * Bordered + Edge + 1] = GrassKernels::ExtrapolateBorderHeight(Heights, Vertices, Edge, I);
+			}
+		}
+		Expect(Heights[1 * Bordered + 0] == 999 && Heights[1 * Bordered + Bordered - 1] == 1000 + Vertices,
+			"border extrapolation continues the slope");
+
+		uint16_t Normals[Vertices * Vertices];
+		uint8_t Slopes[Vertices * Vertices];
+		GrassKernels::ComputeNormalsAndSlopes(Heights, Vertices, GrassKernels::FTerrainScale(), Normals, Slopes);
+
+		bool bUniform = true;
+		for (int32_t Index = 0; Index < Vertices * Vertices; ++Index)
+		{
+			bUniform &= Slopes[Index] == Slopes[0] && Normals[Index] == Normals[0];
+		}
+		Expect(bUniform, "a plane has one normal and one slope, edges included");
+		Expect(std::abs(GrassKernels::DecodeSlope(Slopes[0]) - 45.0f) < 0.5f, "ramp slope is 45 degrees");
+		Expect(static_cast<int8_t>(Normals[0] & 0xff) == -90 && static_cast<int8_t>(Normals[0] >> 8) == 0,
+			"ramp normal leans back along X only");
+		Expect(std::abs(GrassKernels::UnpackNormalZ(Normals[0]) - 0.7071f) < 0.01f, "normal Z is rebuilt");
+
+		uint8_t SlopesOnly[Vertices * Vertices];
+		GrassKernels::ComputeNormalsAndSlopes(Heights, Vertices, GrassKernels::FTerrainScale(), nullptr, SlopesOnly);
+		Expect(std::memcmp(Slopes, SlopesOnly, sizeof(Slopes)) == 0, "slopes come out the same without normals");
+
+		// Two subsections of 3 quads: texels 0-3 are vertices 0-3, texels 4-7 vertices 3-6.
+		Expect(GrassKernels::GetWeightmapTexelVertex(3, 3) == 3 && GrassKernels::GetWeightmapTexelVertex(4, 3) == 3
+			&& GrassKernels::GetWeightmapTexelVertex(7, 3) == 6, "weightmap texels repeat the subsection edge");
+
+		uint8_t Weights[Vertices * Vertices];
+		GrassKernels::FillWeights(255, Vertices * Vertices, Weights);
+		GrassKernels::ApplySlopeLimit(Slopes, Vertices, Vertices - 1, GrassKernels::EncodeSlope(30.0f),
+			Vertices, Vertices, Weights);
+		Expect(Weights[0] == 0 && Weights[Vertices * Vertices - 1] == 0, "slope limit clears steep texels");
+
+		GrassKernels::FillWeights(255, Vertices * Vertices, Weights);
+		GrassKernels::ApplySlopeLimit(Slopes, Vertices, Vertices - 1, GrassKernels::EncodeSlope(60.0f),
+			Vertices, Vertices, Weights);
+		Expect(Weights[0] == 255 && Weights[Vertices * Vertices - 1] == 255, "slope limit keeps shallow texels");
+	}
+
+	/**
+	 * Checksum of the noise over a fixed grid with fixed settings, recorded once. Any change in
+	 * the value is a change in every generated landscape that uses noise: on purpose, bump it
+	 * with the weight tile key version; by accident, it is a determinism bug.
+	 */
+	constexpr uint64_t ExpectedNoiseChecksum = 0xe180a8dfa7d1d6a4ull;
+
+	uint64_t ChecksumNoise(const GrassKernels::FNoiseSettings& Settings, int32_t MinX, int32_t MinY, int32_t Size)
+	{
+		std::vector<int16_t> Row(Size);
+		uint64_t Checksum = 0xcbf29ce484222325ull;
+		for (int32_t Y = MinY; Y < MinY + Size; ++Y)
+		{
+			GrassKernels::EvaluateNoiseRow(Settings, MinX, Y, Size, Row.data());
+			for (const int16_t Value : Row)
+			{
+				Checksum = (Checksum ^ static_cast<uint16_t>(Value)) * 0x100000001b3ull;
+			}
+		}
+		return Checksum;
+	}
+
+	/** The noise: lanes against the scalar reference, tiling, seams between components, and a fixed checksum. */
+	void TestNoise()
+	{
+		GrassKernels::FNoiseSettings Settings;
+		Settings.Seed = 1234;
+		Settings.Frequency = GrassKernels::NoiseOne / 16;
+		Settings.Octaves = 5;
+		Settings.PeriodLog2 = 4;
+
+		// Odd widths and negative coordinates, so the partial last block and the floor of negative
+		// cells are both exercised.
+		bool bRowsMatch = true;
+		int16_t Row[77];
+		for (const int32_t Y : { -300, -1, 0, 17, 255, 4099 })
+		{
+			for (const int32_t X : { -513, -8, 0, 5, 1000 })
+			{
+				GrassKernels::EvaluateNoiseRow(Settings, X, Y, 77, Row);
+				for (int32_t Index = 0; Index < 77; ++Index)
+				{
+					bRowsMatch &= Row[Index] == GrassKernels::EvaluateNoise(Settings, X + Index, Y);
+				}
+			}
+		}
+		Expect(bRowsMatch, "lane evaluation matches the scalar reference bit for bit");
+
+		// 16 vertices per cell and 16 cells per period: the pattern repeats every 256 vertices.
+		bool bTiles = true;
+		int16_t Lowest = 0;
+		int16_t Highest = 0;
+		for (int32_t Y = 0; Y < 256; Y += 7)
+		{
+			for (int32_t X = 0; X < 256; X += 5)
+			{
+				const int16_t Value = GrassKernels::EvaluateNoise(Settings, X, Y);
+				bTiles &= Value == GrassKernels::EvaluateNoise(Settings, X + 256, Y)
+					&& Value == GrassKernels::EvaluateNoise(Settings, X, Y - 256)
+					&& Value == GrassKernels::EvaluateNoise(Settings, X + 512, Y + 768);
+				Lowest = std::min(Lowest, Value);
+				Highest = std::max(Highest, Value);
+			}
+		}
+		Expect(bTiles, "noise tiles at its period");
+		Expect(Highest - Lowest > GrassKernels::NoiseRange / 2, "noise spans a useful part of its range");
+
+		GrassKernels::FNoiseSettings OtherSeed = Settings;
+		OtherSeed.Seed = 1235;
+		Expect(ChecksumNoise(Settings, 0, 0, 64) != ChecksumNoise(OtherSeed, 0, 0, 64), "seeds give different noise");
+
+		// Two components of two 7-quad subsections side by side: 16 texels and 15 vertices each,
+		// sharing the vertex at X = 14. Its texel must come out the same in both.
+		constexpr int32_t SubsectionQuads = 7;
+		constexpr int32_t ComponentQuads = 2 * SubsectionQuads;
+		constexpr int32_t Texels = 2 * (SubsectionQuads + 1);
+		uint8_t Left[Texels * Texels];
+		uint8_t Right[Texels * Texels];
+		GrassKernels::FillWeights(200, Texels * Texels, Left);
+		GrassKernels::FillWeights(200, Texels * Texels, Right);
+		GrassKernels::ModulateWeights(Settings, GrassKernels::NoiseOne, 0, 0, SubsectionQuads, Texels, Texels, Left);
+		GrassKernels::ModulateWeights(Settings, GrassKernels::NoiseOne, ComponentQuads, 0, SubsectionQuads, Texels, Texels, Right);
+
+		bool bSeamless = true;
+		bool bModulated = false;
+		for (int32_t Y = 0; Y < Texels; ++Y)
+		{
+			bSeamless &= Left[Y * Texels + Texels - 1] == Right[Y * Texels];
+			// The two texels of the vertex subsections share, inside one component.
+			bSeamless &= Left[Y * Texels + SubsectionQuads] == Left[Y * Texels + SubsectionQuads + 1];
+			bModulated |= Left[Y * Texels] != 200;
+		}
+		Expect(bSeamless, "modulation agrees across component and subsection seams");
+		Expect(bModulated, "modulation changes the weights");
+
+		uint8_t Unchanged[Texels * Texels];
+		GrassKernels::FillWeights(200, Texels * Texels, Unchanged);
+		GrassKernels::ModulateWeights(Settings, 0, 0, 0, SubsectionQuads, Texels, Texels, Unchanged);
+		Expect(Unchanged[0] == 200 && Unchanged[Texels * Texels - 1] == 200, "zero strength leaves the weights alone");
+
+		// Two vertices per cell, the finest frequency: no vertex may sit on the lattice, where the
+		// noise is zero, and every further octave would alias, so they must be left out.
+		GrassKernels::FNoiseSettings Finest = Settings;
+		Finest.Frequency = GrassKernels::MaxNoiseFrequency;
+		Finest.Octaves = 1;
+		GrassKernels::FNoiseSettings FinestOctaves = Finest;
+		FinestOctaves.Octaves = GrassKernels::MaxNoiseOctaves;
+
+		int32_t Zeros = 0;
+		for (int32_t Y = 0; Y < 64; ++Y)
+		{
+			GrassKernels::EvaluateNoiseRow(Finest, 0, Y, 64, Row);
+			Zeros += static_cast<int32_t>(std::count(Row, Row + 64, int16_t(0)));
+		}
+		Expect(Zeros < 64, "no row or column of vertices sits on the lattice");
+		Expect(ChecksumNoise(Finest, 0, 0, 64) == ChecksumNoise(FinestOctaves, 0, 0, 64), "octaves finer than a vertex are dropped");
+
+		const uint64_t Checksum = ChecksumNoise(Settings, -128, -128, 256);
+		if (Checksum != ExpectedNoiseChecksum)
+		{
+			std::printf("noise checksum %016llx, expected %016llx\n",
+				static_cast<unsigned long long>(Checksum), static_cast<unsigned long long>(ExpectedNoiseChecksum));
+		}
+		Expect(Checksum == ExpectedNoiseChecksum, "noise matches its recorded checksum");
+	}
+
+	struct FTest
+	{
+		const char* Name;
+		void (*Run)();
+	};
+
+	const FTest Tests[] = {
+		{ "placement", TestPlacementMath },
+		{ "channels", TestChannels },
+		{ "terrain", TestTerrainMath },
+		{ "noise", TestNoise },
+	};
+}
+
+int main(int ArgCount, char** Args)
+{
+	const char* const Only = ArgCount > 1 ? Args[1] : nullptr;
+
+	bool bRanAny = false;
+	for (const FTest& Test : Tests)
+	{
+		if (Only && std::strcmp(Only, Test.Name) != 0)
+		{
+			continue;
+		}
+
+		const int32_t FailuresBefore = FailureCount;
+		Test.Run();
+		std::printf("%s: %s\n", Test.Name, FailureCount == FailuresBefore ? "ok" : "FAILED");
+		bRanAny = true;
+	}
+
+	if (!bRanAny)
+	{
+		std::printf("No test named '%s'.\n", Only);
+		return 1;
+	}
+
+	return FailureCount == 0 ? 0 : 1;
+}